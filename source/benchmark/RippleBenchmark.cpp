@@ -0,0 +1,289 @@
+#include "RippleBenchmark.h"
+#include <math.h>
+#include <algorithm>
+#include <core/Clock.h>
+
+//the depth of a touch drop in Water
+static const int BENCH_DROP_DEPTH = 16;
+
+//cells per rain drop and step
+static const int BENCH_RAIN_CELLS = 128*128;
+
+//steps for one turn of the drag
+static const int BENCH_DRAG_STEPS = 120;
+
+//radii of the pressed finger, as wide as a touch drop and half as high
+static const int BENCH_PRESS_RADIUS_X = 12;
+static const int BENCH_PRESS_RADIUS_Y = 6;
+
+//grid and steps of the stamp check
+static const int STAMP_CHECK_SIZE = 64;
+static const int STAMP_CHECK_STEPS = 32;
+
+const char* getBenchInputName(E_Bench_Input input)
+{
+	switch (input)
+	{
+	case EBI_IDLE:			return "idle";
+	case EBI_SINGLE_DROP:	return "single_drop";
+	case EBI_DRAG:			return "drag";
+	case EBI_RAIN:			return "rain";
+	case EBI_PRESS:			return "press";
+	default:				return "unknown";
+	}
+}
+
+//! Feeds one step of input, the same sequence for every run.
+class BenchInput
+{
+public:
+	//! firstStep is the first timed step, the single drop falls there
+	BenchInput(E_Bench_Input input, int width, int height, int firstStep):m_input(input)
+		,m_width(width)
+		,m_height(height)
+		,m_firstStep(firstStep)
+		,m_random(12345)
+		,m_lastX(0)
+		,m_lastY(0)
+		,m_pressStamp(nullptr)
+	{
+		if (input == EBI_PRESS)
+			m_pressStamp = DropStamp::CreateEllipse(BENCH_PRESS_RADIUS_X, BENCH_PRESS_RADIUS_Y, BENCH_DROP_DEPTH);
+	}
+
+	~BenchInput()
+	{
+		delete m_pressStamp;
+	}
+
+	void Apply(RippleSimulation& simulation, int step)
+	{
+		switch (m_input)
+		{
+		case EBI_SINGLE_DROP:
+			if (step == m_firstStep)
+				simulation.Drop(m_width/2, m_height/2, BENCH_DROP_DEPTH);
+			break;
+
+		case EBI_DRAG:
+			{
+				float angle = 2.0f*3.14159265f*(step%BENCH_DRAG_STEPS)/BENCH_DRAG_STEPS;
+				float radius = std::min(m_width, m_height)/4.0f;
+				int x = m_width/2 + int(radius*cosf(angle));
+				int y = m_height/2 + int(radius*sinf(angle));
+				if (step == 0)
+					simulation.Drop(x, y, BENCH_DROP_DEPTH);
+				else
+					simulation.DropSegment(m_lastX, m_lastY, x, y, BENCH_DROP_DEPTH);
+				m_lastX = x;
+				m_lastY = y;
+			}
+			break;
+
+		case EBI_RAIN:
+		case EBI_PRESS:
+			{
+				int count = std::max(1, m_width*m_height/BENCH_RAIN_CELLS);
+				for (int i=0; i<count; ++i)
+				{
+					int x = int(this->_nextRandom()%u32(m_width));
+					int y = int(this->_nextRandom()%u32(m_height));
+					if (m_pressStamp)
+						simulation.Drop(x, y, m_pressStamp);
+					else
+						simulation.Drop(x, y, BENCH_DROP_DEPTH);
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+private:
+	//a fixed lcg, so every run and every platform rains on the same cells
+	u32 _nextRandom()
+	{
+		m_random = m_random*1664525u + 1013904223u;
+		return m_random >> 8;
+	}
+
+	E_Bench_Input	m_input;
+	int				m_width;
+	int				m_height;
+	int				m_firstStep;
+	u32				m_random;
+	int				m_lastX;
+	int				m_lastY;
+	DropStamp*		m_pressStamp;
+};
+
+//drops the stamp in the centre and half off the left border of a grid at rest,
+//the checksum after the waves had some steps to spread
+static u64 stampChecksum(const DropStamp* stamp, E_Ripple_Precision precision)
+{
+	RippleSimulation simulation(STAMP_CHECK_SIZE, STAMP_CHECK_SIZE, 1, precision);
+	simulation.Drop(STAMP_CHECK_SIZE/2, STAMP_CHECK_SIZE/2, stamp);
+	simulation.Drop(0, STAMP_CHECK_SIZE/3, stamp);
+	for (int step=0; step<STAMP_CHECK_STEPS; ++step)
+		simulation.Step();
+	return simulation.GetHeightChecksum();
+}
+
+bool verifyDropStamps()
+{
+	const int radiusX = BENCH_PRESS_RADIUS_X;
+	const int radiusY = BENCH_PRESS_RADIUS_Y;
+	DropStamp* ellipse = DropStamp::CreateEllipse(radiusX, radiusY, BENCH_DROP_DEPTH);
+
+	//the whole box, cells the stamp leaves alone keep a height no drop writes
+	const int unwritten = -1000;
+	int width = ellipse->GetWidth();
+	int height = ellipse->GetHeight();
+	std::vector<int> heights(width*height, unwritten);
+	ellipse->Write(&heights[0], width, -ellipse->GetLeft(), -ellipse->GetTop(), 0, 0, width, height);
+
+	bool footprint = (width == 2*radiusX && height == 2*radiusY);
+	for (int j=0; j<height && footprint; ++j)
+	{
+		for (int i=0; i<width; ++i)
+		{
+			float dx = float(i - radiusX)/radiusX;
+			float dy = float(j - radiusY)/radiusY;
+			bool written = heights[j*width + i] != unwritten;
+			bool onAxis = (i == radiusX && j > 0) || (j == radiusY && i > 0);
+
+			//a little slack at the rim, where the distance rounds either way
+			if ((written && dx*dx + dy*dy > 1.0001f) || (onAxis && !written))
+				footprint = false;
+			if (written && (heights[j*width + i] < 0 || heights[j*width + i] > BENCH_DROP_DEPTH))
+				footprint = false;
+		}
+	}
+	footprint = footprint && heights[radiusY*width + radiusX] == BENCH_DROP_DEPTH;
+
+	//on a grid at rest the 0 cells the image leaves out change nothing
+	for (size_t i=0; i<heights.size(); ++i)
+	{
+		if (heights[i] == unwritten)
+			heights[i] = 0;
+	}
+	DropStamp* image = DropStamp::CreateFromImage(&heights[0], width, height);
+
+	//the waves must still be moving, or any stamp would pass
+	RippleSimulation rest(STAMP_CHECK_SIZE, STAMP_CHECK_SIZE, 1, ERP_INT32);
+	u64 expected = stampChecksum(ellipse, ERP_INT32);
+	bool checksums = expected != rest.GetHeightChecksum();
+	for (int p=0; p<ERP_COUNT; ++p)
+	{
+		checksums = checksums && stampChecksum(ellipse, E_Ripple_Precision(p)) == expected;
+		checksums = checksums && stampChecksum(image, E_Ripple_Precision(p)) == expected;
+	}
+
+	delete ellipse;
+	delete image;
+	return footprint && checksums;
+}
+
+RippleBenchmarkResult runRippleBenchmark(const RippleBenchmarkSettings& settings)
+{
+	RippleSimulation simulation(settings.width, settings.height, settings.threadCount, settings.precision,
+		settings.uvFormat);
+	BenchInput input(settings.input, settings.width, settings.height, settings.warmupSteps);
+
+	int width = settings.width;
+	int uvSize = getUVFormatSize(settings.uvFormat);
+	std::vector<u8> uv(width*settings.height*uvSize, 0);
+
+	int heightSize = (settings.precision == ERP_INT16) ? sizeof(s16) : sizeof(int);
+
+	double cellCount = double(width)*settings.height;
+	double bytes = 0.0;
+	double activeFraction = 0.0;
+	u64 maxStep = 0;
+	u64 start = 0;
+	int totalSteps = settings.warmupSteps + settings.steps;
+	for (int step=0; step<totalSteps; ++step)
+	{
+		if (step == settings.warmupSteps)
+			start = getTimeMicroseconds();
+
+		u64 stepStart = getTimeMicroseconds();
+		input.Apply(simulation, step);
+		RowRange rows = simulation.GetStepRows();
+		simulation.Step(&uv[0] + rows.begin*width*uvSize, rows);
+		u64 stepEnd = getTimeMicroseconds();
+
+		if (step >= settings.warmupSteps)
+		{
+			//heights read, previous heights read and written, offsets written,
+			//for the cells of the tiles that are still moving
+			double active = double(simulation.GetActiveTileCount())/simulation.GetTileCount();
+			bytes += active*cellCount*(3*heightSize + uvSize);
+			activeFraction += active;
+			maxStep = std::max(maxStep, stepEnd - stepStart);
+		}
+	}
+	u64 end = getTimeMicroseconds();
+
+	RippleBenchmarkResult result;
+	result.settings = settings;
+	result.kernel = simulation.GetKernel();
+	result.threadCount = simulation.GetThreadCount();
+	result.seconds = std::max(end - start, u64(1))/1000000.0;
+	result.maxStepMicroseconds = double(maxStep);
+
+	int steps = std::max(settings.steps, 1);
+	double cells = cellCount*steps;
+	result.nsPerCell = result.seconds*1e9/cells;
+	result.cellsPerSecond = cells/result.seconds;
+	result.bytesPerSecond = bytes/result.seconds;
+	result.activeFraction = std::min(activeFraction/steps, 1.0);
+	result.checksum = simulation.GetHeightChecksum();
+	return result;
+}
+
+void writeBenchmarkTableHeader(FILE* file)
+{
+	fprintf(file, "%-11s %-12s %-6s %-6s %10s %12s %10s %8s %10s\n",
+		"grid", "input", "height", "uv", "ns/cell", "Mcells/s", "GB/s", "active", "max us");
+}
+
+void writeBenchmarkTableRow(FILE* file, const RippleBenchmarkResult& result)
+{
+	char grid[32];
+	sprintf(grid, "%dx%d", result.settings.width, result.settings.height);
+	fprintf(file, "%-11s %-12s %-6s %-6s %10.3f %12.1f %10.2f %7.1f%% %10.0f\n",
+		grid, getBenchInputName(result.settings.input), getRipplePrecisionName(result.settings.precision),
+		getUVFormatName(result.settings.uvFormat),
+		result.nsPerCell, result.cellsPerSecond/1e6, result.bytesPerSecond/1e9,
+		result.activeFraction*100.0, result.maxStepMicroseconds);
+}
+
+bool writeBenchmarkJson(const char* path, const std::vector<RippleBenchmarkResult>& results)
+{
+	FILE* file = fopen(path, "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "{\"benchmark\":\"ripple\",\"results\":[\n");
+	for (size_t i=0; i<results.size(); ++i)
+	{
+		const RippleBenchmarkResult& result = results[i];
+		const RippleBenchmarkSettings& settings = result.settings;
+		fprintf(file, "{\"width\":%d,\"height\":%d,\"input\":\"%s\",\"precision\":\"%s\",\"uv_format\":\"%s\",\"kernel\":\"%s\",\"threads\":%d,"
+			"\"warmup_steps\":%d,\"steps\":%d,\"seconds\":%.6f,\"ns_per_cell\":%.4f,\"cells_per_second\":%.0f,"
+			"\"bytes_per_second\":%.0f,\"active_fraction\":%.4f,\"max_step_us\":%.0f,\"checksum\":\"%016llx\"}%s\n",
+			settings.width, settings.height, getBenchInputName(settings.input),
+			getRipplePrecisionName(settings.precision), getUVFormatName(settings.uvFormat),
+			getRippleKernelName(result.kernel), result.threadCount,
+			settings.warmupSteps, settings.steps, result.seconds, result.nsPerCell, result.cellsPerSecond,
+			result.bytesPerSecond, result.activeFraction, result.maxStepMicroseconds,
+			(unsigned long long)result.checksum, (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(file, "]}\n");
+
+	fclose(file);
+	return true;
+}
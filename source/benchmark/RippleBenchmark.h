@@ -0,0 +1,96 @@
+#pragma once
+#include <stdio.h>
+#include <vector>
+#include <core/types.h>
+#include "livewallpaper/RippleSimulation.h"
+
+//! Touch input a benchmark run feeds into the solver every step.
+enum E_Bench_Input
+{
+	//no drops, measures the cost of a grid at rest
+	EBI_IDLE = 0,
+
+	//one drop in the centre before the first timed step, the rings spread out
+	EBI_SINGLE_DROP,
+
+	//a finger circling around the centre, one swept segment per step
+	EBI_DRAG,
+
+	//drops at random cells, about one per 128x128 cells every step
+	EBI_RAIN,
+
+	//rain of ellipse stamps, a finger pressed flat instead of a round drop
+	EBI_PRESS,
+
+	EBI_COUNT,
+};
+
+const char* getBenchInputName(E_Bench_Input input);
+
+struct RippleBenchmarkSettings
+{
+	RippleBenchmarkSettings():width(512)
+							,height(512)
+							,input(EBI_RAIN)
+							,precision(ERP_INT16)
+							,uvFormat(EUF_INT16)
+							,threadCount(0)
+							,warmupSteps(60)
+							,steps(240)
+	{
+	}
+
+	int					width;
+	int					height;
+	E_Bench_Input		input;
+	E_Ripple_Precision	precision;
+	E_UV_Format			uvFormat;
+
+	//solver threads, 0 for one per processor
+	int					threadCount;
+
+	//steps run before timing, drag and rain reach their steady state
+	int					warmupSteps;
+	int					steps;
+};
+
+struct RippleBenchmarkResult
+{
+	RippleBenchmarkSettings	settings;
+	E_Ripple_Kernel			kernel;
+	int						threadCount;
+
+	//wall time of the timed steps, drops included
+	double					seconds;
+	double					maxStepMicroseconds;
+
+	//per cell of the whole grid, resting cells count too
+	double					nsPerCell;
+	double					cellsPerSecond;
+
+	//height and uv offset bytes of the moving tiles, an estimate that leaves out
+	//caches and the halo rows of the bands
+	double					bytesPerSecond;
+
+	//active tiles after a step over all tiles, averaged
+	double					activeFraction;
+
+	//RippleSimulation::GetHeightChecksum() after the last step, changes when
+	//the solver steps to other heights
+	u64						checksum;
+};
+
+//! Checks the ellipse stamp EBI_PRESS drops before it is timed: the cells it
+//! writes lie inside the ellipse and cover both axes, and an image stamp of
+//! the same heights steps to the same checksum in every precision.
+bool verifyDropStamps();
+
+//! Steps a RippleSimulation the way Water does on the simulation thread,
+//! fused with the uv pass, without any GL.
+RippleBenchmarkResult runRippleBenchmark(const RippleBenchmarkSettings& settings);
+
+void writeBenchmarkTableHeader(FILE* file);
+void writeBenchmarkTableRow(FILE* file, const RippleBenchmarkResult& result);
+
+//! All results as one JSON document.
+bool writeBenchmarkJson(const char* path, const std::vector<RippleBenchmarkResult>& results);
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "RippleBenchmark.h"
+
+//grid and steps of the precision check, long enough for its drops to ring out
+static const int PRECISION_CHECK_SIZE = 128;
+static const int PRECISION_CHECK_STEPS = 512;
+
+static void printUsage(const char* program)
+{
+	printf("usage: %s [-s grid size] [-i idle|single_drop|drag|rain|press] [-p int16|int32] [-j threads]\n"
+		"\t[-u float|int16|int8] [-w warmup steps] [-n steps] [-o results.json]\n"
+		"without -s, -i or -p every grid from 128 to 2048, input and precision is run\n", program);
+}
+
+int main(int argc, char *argv[])
+{
+	int gridSize = 0;
+	int input = -1;
+	int precision = -1;
+	const char* jsonPath = NULL;
+	RippleBenchmarkSettings settings;
+
+	for (int i=1; i<argc; i+=2)
+	{
+		if (i + 1 >= argc)
+		{
+			printUsage(argv[0]);
+			return 2;
+		}
+
+		const char* value = argv[i + 1];
+		if (strcmp(argv[i], "-s") == 0)
+			gridSize = atoi(value);
+		else if (strcmp(argv[i], "-i") == 0)
+		{
+			for (int j=0; j<EBI_COUNT; ++j)
+			{
+				if (strcmp(value, getBenchInputName(E_Bench_Input(j))) == 0)
+					input = j;
+			}
+			if (input < 0)
+			{
+				printUsage(argv[0]);
+				return 2;
+			}
+		}
+		else if (strcmp(argv[i], "-p") == 0)
+		{
+			for (int j=0; j<ERP_COUNT; ++j)
+			{
+				if (strcmp(value, getRipplePrecisionName(E_Ripple_Precision(j))) == 0)
+					precision = j;
+			}
+			if (precision < 0)
+			{
+				printUsage(argv[0]);
+				return 2;
+			}
+		}
+		else if (strcmp(argv[i], "-u") == 0)
+		{
+			int format = -1;
+			for (int j=0; j<EUF_COUNT; ++j)
+			{
+				if (strcmp(value, getUVFormatName(E_UV_Format(j))) == 0)
+					format = j;
+			}
+			if (format < 0)
+			{
+				printUsage(argv[0]);
+				return 2;
+			}
+			settings.uvFormat = E_UV_Format(format);
+		}
+		else if (strcmp(argv[i], "-j") == 0)
+			settings.threadCount = atoi(value);
+		else if (strcmp(argv[i], "-w") == 0)
+			settings.warmupSteps = atoi(value);
+		else if (strcmp(argv[i], "-n") == 0)
+			settings.steps = atoi(value);
+		else if (strcmp(argv[i], "-o") == 0)
+			jsonPath = value;
+		else
+		{
+			printUsage(argv[0]);
+			return 2;
+		}
+	}
+
+	if (gridSize < 0 || gridSize == 1 || settings.steps <= 0 || settings.warmupSteps < 0)
+	{
+		printUsage(argv[0]);
+		return 2;
+	}
+
+	std::vector<int> sizes;
+	if (gridSize)
+		sizes.push_back(gridSize);
+	else
+	{
+		for (int size=128; size<=2048; size*=2)
+			sizes.push_back(size);
+	}
+
+	if ((input < 0 || input == EBI_PRESS) && !verifyDropStamps())
+	{
+		printf("the press stamp writes the wrong cells or heights\n");
+		return 1;
+	}
+
+	//a precision that steps to other heights than int32 is not worth timing. Under
+	//rain int16 still drifts once it saturates, its checksums differ from there on
+	for (int p=0; p<ERP_COUNT; ++p)
+	{
+		if (p == ERP_INT32 || (precision >= 0 && p != precision))
+			continue;
+
+		if (!RippleSimulation::VerifyPrecision(E_Ripple_Precision(p), PRECISION_CHECK_SIZE, PRECISION_CHECK_SIZE,
+			PRECISION_CHECK_STEPS))
+		{
+			printf("%s heights differ from int32\n", getRipplePrecisionName(E_Ripple_Precision(p)));
+			return 1;
+		}
+	}
+
+	std::vector<RippleBenchmarkResult> results;
+	writeBenchmarkTableHeader(stdout);
+	for (size_t s=0; s<sizes.size(); ++s)
+	{
+		for (int i=0; i<EBI_COUNT; ++i)
+		{
+			for (int p=0; p<ERP_COUNT; ++p)
+			{
+				if ((input >= 0 && i != input) || (precision >= 0 && p != precision))
+					continue;
+
+				settings.width = sizes[s];
+				settings.height = sizes[s];
+				settings.input = E_Bench_Input(i);
+				settings.precision = E_Ripple_Precision(p);
+				results.push_back(runRippleBenchmark(settings));
+				writeBenchmarkTableRow(stdout, results.back());
+				fflush(stdout);
+			}
+		}
+	}
+
+	if (jsonPath && !writeBenchmarkJson(jsonPath, results))
+	{
+		printf("can't write %s\n", jsonPath);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,106 @@
+#include "Clock.h"
+#if defined(_WIN32)
+#include <Windows.h>
+#include <mmsystem.h>
+#else
+#include <time.h>
+#include <errno.h>
+#include <sched.h>
+#endif
+
+#if defined(_WIN32)
+
+u64 getTimeMicroseconds()
+{
+	static LARGE_INTEGER frequency = {0};
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return u64(counter.QuadPart/frequency.QuadPart)*1000000
+		+ u64(counter.QuadPart%frequency.QuadPart)*1000000/frequency.QuadPart;
+}
+
+//finest scheduler tick timeBeginPeriod() can ask for, in milliseconds
+static UINT getTimerPeriod()
+{
+	static UINT period = 0;
+	if (period == 0)
+	{
+		TIMECAPS caps;
+		period = (timeGetDevCaps(&caps, sizeof(caps)) == TIMERR_NOERROR && caps.wPeriodMin > 0) ? caps.wPeriodMin : 1;
+	}
+	return period;
+}
+
+void sleepMicroseconds(u64 duration)
+{
+	//the default tick is 15.6ms, far too coarse to pace frames. It is raised
+	//only for the sleep, an idle wallpaper leaves the system timer alone
+	UINT period = getTimerPeriod();
+	bool raised = timeBeginPeriod(period) == TIMERR_NOERROR;
+	Sleep(DWORD((duration + 999)/1000));
+	if (raised)
+		timeEndPeriod(period);
+}
+
+//Sleep() rounds up to whole ticks and may wake a tick late on top
+static u64 getSleepSlackMicroseconds()
+{
+	return 2*u64(getTimerPeriod())*1000;
+}
+
+static void yieldThread()
+{
+	SwitchToThread();
+}
+
+#else
+
+u64 getTimeMicroseconds()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return u64(now.tv_sec)*1000000 + u64(now.tv_nsec)/1000;
+}
+
+void sleepMicroseconds(u64 duration)
+{
+	timespec request;
+	request.tv_sec = time_t(duration/1000000);
+	request.tv_nsec = long(duration%1000000)*1000;
+	while (nanosleep(&request, &request) != 0 && errno == EINTR)
+	{
+	}
+}
+
+//nanosleep() wakes within the timer slack, 50us by default
+static u64 getSleepSlackMicroseconds()
+{
+	return 200;
+}
+
+static void yieldThread()
+{
+	sched_yield();
+}
+
+#endif
+
+void sleepUntilMicroseconds(u64 deadline)
+{
+	u64 now = getTimeMicroseconds();
+	u64 slack = getSleepSlackMicroseconds();
+	if (now + slack < deadline)
+	{
+		sleepMicroseconds(deadline - now - slack);
+		now = getTimeMicroseconds();
+	}
+
+	while (now < deadline)
+	{
+		yieldThread();
+		now = getTimeMicroseconds();
+	}
+}
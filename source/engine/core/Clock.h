@@ -0,0 +1,14 @@
+#pragma once
+#include "types.h"
+
+//! Monotonic high resolution time, in microseconds from an arbitrary origin.
+u64 getTimeMicroseconds();
+
+//! Blocks the calling thread for at least the given time.
+void sleepMicroseconds(u64 duration);
+
+//! Blocks until getTimeMicroseconds() reaches deadline. Sleeps while the
+//! deadline is further away than the scheduler's granularity and only yields
+//! for the last stretch, so it wakes close to the deadline without spinning
+//! a core.
+void sleepUntilMicroseconds(u64 deadline);
@@ -0,0 +1,45 @@
+#include "FramePacer.h"
+#include "Clock.h"
+
+FramePacer::FramePacer(int framesPerSecond):m_framesPerSecond(0)
+	,m_period(0)
+	,m_nextFrame(0)
+{
+	this->setFrameRate(framesPerSecond);
+}
+
+void FramePacer::setFrameRate(int framesPerSecond)
+{
+	m_framesPerSecond = framesPerSecond > 0 ? framesPerSecond : 0;
+	m_period = m_framesPerSecond > 0 ? 1000000/m_framesPerSecond : 0;
+	this->restart();
+}
+
+void FramePacer::wait()
+{
+	if (m_period == 0)
+		return;
+
+	u64 now = getTimeMicroseconds();
+	if (now > m_nextFrame + m_period)
+	{
+		//too late to catch up, the next frame is due right now
+		m_nextFrame = now;
+	}
+	else if (now < m_nextFrame)
+	{
+		sleepUntilMicroseconds(m_nextFrame);
+	}
+	m_nextFrame += m_period;
+}
+
+u64 FramePacer::getTimeToNextFrame() const
+{
+	u64 now = getTimeMicroseconds();
+	return now < m_nextFrame ? m_nextFrame - now : 0;
+}
+
+void FramePacer::restart()
+{
+	m_nextFrame = getTimeMicroseconds();
+}
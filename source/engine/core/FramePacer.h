@@ -0,0 +1,38 @@
+#pragma once
+#include "types.h"
+
+//! Paces a render loop to a fixed frame rate.
+//!
+//! Frames are due on a fixed grid of deadlines, wait() sleeps until the next
+//! one, so the time spent rendering does not add up into drift. A loop that
+//! falls behind by more than a frame restarts the grid at the current time
+//! instead of rendering the missed frames back to back.
+class FramePacer
+{
+public:
+	//! 0 frames per second never waits.
+	explicit FramePacer(int framesPerSecond = 60);
+
+	void setFrameRate(int framesPerSecond);
+	int getFrameRate() const;
+
+	//! Blocks until the next frame is due and schedules the one after it.
+	void wait();
+
+	//! Microseconds until the next frame is due, 0 when it already is.
+	u64 getTimeToNextFrame() const;
+
+	//! The next frame is due right away, e.g. after the loop slept on input.
+	void restart();
+
+private:
+	int		m_framesPerSecond;
+	u64		m_period;
+	u64		m_nextFrame;
+};
+
+inline int
+FramePacer::getFrameRate() const
+{
+	return m_framesPerSecond;
+}
@@ -0,0 +1,208 @@
+#include "Profiler.h"
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(_MSC_VER)
+#define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILER_THREAD_LOCAL __thread
+#endif
+
+static std::atomic<u32> s_nextThreadTrack(0);
+static PROFILER_THREAD_LOCAL u32 s_threadTrack = 0;
+
+u32 Profiler::getThreadTrack()
+{
+	//0 means not assigned yet, tracks start at 1
+	if (s_threadTrack == 0)
+		s_threadTrack = s_nextThreadTrack.fetch_add(1) + 1;
+	return s_threadTrack;
+}
+
+Profiler::Profiler(int capacity):m_slots(nullptr)
+	,m_mask(0)
+	,m_writeIndex(0)
+{
+	u32 size = 1;
+	while (size < u32(capacity))
+		size <<= 1;
+
+	m_slots = new Slot[size];
+	m_mask = size - 1;
+	for (u32 i=0; i<size; ++i)
+		m_slots[i].sequence.store(0, std::memory_order_relaxed);
+}
+
+Profiler::~Profiler()
+{
+	delete[] m_slots;
+}
+
+void Profiler::record(const char* name, u64 begin, u64 end, u32 track)
+{
+	u64 index = m_writeIndex.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = m_slots[index & m_mask];
+
+	//sequence 0 marks the slot as being written, readers skip it
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot.sample.name = name;
+	slot.sample.begin = begin;
+	slot.sample.end = end;
+	slot.sample.track = track;
+
+	slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+int Profiler::snapshot(ProfileSample* samples, int maxCount) const
+{
+	u64 end = m_writeIndex.load(std::memory_order_acquire);
+	u64 capacity = u64(m_mask) + 1;
+	u64 begin = end > capacity ? end - capacity : 0;
+	if (end - begin > u64(maxCount))
+		begin = end - maxCount;
+
+	int count = 0;
+	for (u64 i=begin; i<end; ++i)
+	{
+		const Slot& slot = m_slots[i & m_mask];
+		u64 sequence = slot.sequence.load(std::memory_order_acquire);
+		if (sequence != i + 1)
+			continue;
+
+		ProfileSample sample = slot.sample;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+			continue;
+
+		samples[count++] = sample;
+	}
+	return count;
+}
+
+static double percentile(const std::vector<u64>& sorted, double fraction)
+{
+	//nearest rank
+	size_t rank = size_t(fraction*sorted.size());
+	return double(sorted[std::min(rank, sorted.size() - 1)]);
+}
+
+int Profiler::getStageStats(ProfileStageStats* stats, int maxCount) const
+{
+	std::vector<ProfileSample> samples(this->getCapacity());
+	samples.resize(this->snapshot(&samples[0], int(samples.size())));
+
+	std::vector<std::vector<u64> > durations;
+	int count = 0;
+	for (size_t i=0; i<samples.size(); ++i)
+	{
+		const ProfileSample& sample = samples[i];
+
+		int stage = 0;
+		while (stage < count && (stats[stage].track != sample.track || strcmp(stats[stage].name, sample.name) != 0))
+			++stage;
+
+		if (stage == count)
+		{
+			if (count == maxCount)
+				continue;
+
+			stats[count].name = sample.name;
+			stats[count].track = sample.track;
+			durations.push_back(std::vector<u64>());
+			++count;
+		}
+		durations[stage].push_back(sample.end - sample.begin);
+	}
+
+	for (int stage=0; stage<count; ++stage)
+	{
+		std::vector<u64>& stageDurations = durations[stage];
+		std::sort(stageDurations.begin(), stageDurations.end());
+
+		u64 total = 0;
+		for (size_t i=0; i<stageDurations.size(); ++i)
+			total += stageDurations[i];
+
+		ProfileStageStats& stageStats = stats[stage];
+		stageStats.count = int(stageDurations.size());
+		stageStats.average = double(total)/stageDurations.size();
+		stageStats.p50 = percentile(stageDurations, 0.5);
+		stageStats.p99 = percentile(stageDurations, 0.99);
+		stageStats.max = double(stageDurations.back());
+	}
+	return count;
+}
+
+static void writeJsonString(FILE* file, const char* text)
+{
+	fputc('"', file);
+	for (; *text; ++text)
+	{
+		if (*text == '"' || *text == '\\')
+			fputc('\\', file);
+		fputc(*text, file);
+	}
+	fputc('"', file);
+}
+
+bool Profiler::writeChromeTrace(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+	if (!file)
+		return false;
+
+	std::vector<ProfileSample> samples(this->getCapacity());
+	samples.resize(this->snapshot(&samples[0], int(samples.size())));
+
+	//timestamps relative to the oldest sample keep the numbers short
+	u64 origin = ~u64(0);
+	for (size_t i=0; i<samples.size(); ++i)
+		origin = std::min(origin, samples[i].begin);
+
+	std::vector<u32> tracks;
+	fprintf(file, "{\"traceEvents\":[\n");
+	for (size_t i=0; i<samples.size(); ++i)
+	{
+		const ProfileSample& sample = samples[i];
+		if (std::find(tracks.begin(), tracks.end(), sample.track) == tracks.end())
+			tracks.push_back(sample.track);
+
+		fprintf(file, "{\"name\":");
+		writeJsonString(file, sample.name);
+		fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%llu},\n",
+			sample.track >= GPU_TRACK ? "gpu" : "cpu", sample.track,
+			(unsigned long long)(sample.begin - origin), (unsigned long long)(sample.end - sample.begin));
+	}
+
+	//name the tracks, this also closes the array without a trailing comma
+	for (size_t i=0; i<tracks.size(); ++i)
+	{
+		if (tracks[i] >= GPU_TRACK)
+			fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}},\n", tracks[i]);
+		else
+			fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}},\n", tracks[i], tracks[i]);
+	}
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"LiveWallPaper\"}}\n]}\n");
+
+	fclose(file);
+	return true;
+}
+
+void Profiler::writeStats(FILE* file) const
+{
+	static const int MAX_STAGES = 64;
+	ProfileStageStats stats[MAX_STAGES];
+	int count = this->getStageStats(stats, MAX_STAGES);
+
+	fprintf(file, "%-32s %6s %7s %10s %10s %10s %10s\n", "stage", "track", "count", "avg us", "p50 us", "p99 us", "max us");
+	for (int i=0; i<count; ++i)
+	{
+		const ProfileStageStats& stage = stats[i];
+		fprintf(file, "%-32s %6s %7d %10.1f %10.1f %10.1f %10.1f\n",
+			stage.name, stage.track >= GPU_TRACK ? "gpu" : "cpu", stage.count,
+			stage.average, stage.p50, stage.p99, stage.max);
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <stdio.h>
+#include <atomic>
+#include "types.h"
+#include "singleton.h"
+#include "Clock.h"
+
+//! One timed stage, begin and end in getTimeMicroseconds() time.
+struct ProfileSample
+{
+	const char*	name;
+	u64			begin;
+	u64			end;
+	u32			track;
+};
+
+//! Duration percentiles of every sample with the same name, in microseconds.
+struct ProfileStageStats
+{
+	const char*	name;
+	u32			track;
+	int			count;
+	double		average;
+	double		p50;
+	double		p99;
+	double		max;
+};
+
+//! Collects timed samples from any thread into a fixed size lock-free ring.
+//!
+//! Writers claim a slot with a single atomic increment and never wait, the
+//! oldest samples are overwritten once the ring is full. Readers take a
+//! consistent snapshot of whatever is still in the ring, skipping slots that
+//! are being rewritten at the same time.
+//!
+//! Scopes are free while no Profiler instance exists.
+class Profiler:public Singleton<Profiler>
+{
+	friend class Singleton<Profiler>;
+
+public:
+	//! Tracks below GPU_TRACK are CPU threads in order of their first sample.
+	enum
+	{
+		GPU_TRACK = 0x100,
+	};
+
+	void record(const char* name, u64 begin, u64 end, u32 track);
+	void record(const char* name, u64 begin, u64 end);
+
+	//! Copies out the samples still in the ring, oldest first.
+	int snapshot(ProfileSample* samples, int maxCount) const;
+
+	//! One entry per stage name and track, in order of first appearance.
+	int getStageStats(ProfileStageStats* stats, int maxCount) const;
+
+	//! Complete events for chrome://tracing or Perfetto.
+	bool writeChromeTrace(const char* path) const;
+
+	//! Text table of getStageStats().
+	void writeStats(FILE* file) const;
+
+	int getCapacity() const;
+
+	//! Small id of the calling thread, stable for its lifetime.
+	static u32 getThreadTrack();
+
+protected:
+	//! capacity is rounded up to a power of two
+	explicit Profiler(int capacity = 1<<16);
+	~Profiler();
+
+private:
+	struct Slot
+	{
+		std::atomic<u64>	sequence;
+		ProfileSample		sample;
+	};
+
+	Slot*				m_slots;
+	u32					m_mask;
+	std::atomic<u64>	m_writeIndex;
+};
+
+inline void
+Profiler::record(const char* name, u64 begin, u64 end)
+{
+	this->record(name, begin, end, getThreadTrack());
+}
+
+inline int
+Profiler::getCapacity() const
+{
+	return int(m_mask + 1);
+}
+
+//! Times the enclosing block on the calling thread.
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name)
+		:m_name(name)
+		,m_begin(Profiler::instance() ? getTimeMicroseconds() : 0)
+	{
+	}
+
+	~ProfileScope()
+	{
+		Profiler* profiler = Profiler::instance();
+		if (profiler && m_begin)
+			profiler->record(m_name, m_begin, getTimeMicroseconds());
+	}
+
+private:
+	const char*	m_name;
+	u64			m_begin;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+//! name must outlive the profiler, a string literal in practice
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
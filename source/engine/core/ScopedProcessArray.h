@@ -1,4 +1,5 @@
 #pragma once
+#include <stddef.h>
 #include "ProcessBufferHeap.h"
 
 template<typename T>
@@ -21,12 +22,12 @@ public:
         return mBuffer;
     }
 
-    T& operator [](const unsigned __int64 i)
+    T& operator [](const size_t i)
     {
         return mBuffer[i];
     }
 
-    const T& operator [](const unsigned __int64 i) const
+    const T& operator [](const size_t i) const
     {
         return mBuffer[i];
     }
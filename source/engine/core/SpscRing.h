@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+
+//! Lock-free single producer / single consumer ring of CAPACITY items.
+//!
+//! The producer push()es, the consumer pop()s in the same order. Each index is
+//! written by one side only, so neither side ever waits; push() fails instead
+//! of overwriting when the consumer has fallen CAPACITY items behind.
+template<typename T, unsigned int CAPACITY>
+class SpscRing
+{
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+public:
+	SpscRing();
+
+	//producer side, false when the ring is full
+	bool	push(const T& item);
+
+	//consumer side, false when the ring is empty
+	bool	pop(T& item);
+	bool	isEmpty() const;
+
+private:
+	enum
+	{
+		INDEX_MASK = CAPACITY - 1,
+		CACHE_LINE_SIZE = 64,
+	};
+
+	T						m_items[CAPACITY];
+
+	//on separate cache lines, so the two sides don't keep stealing one
+	std::atomic<unsigned>	m_head;
+	char					m_padding[CACHE_LINE_SIZE - sizeof(std::atomic<unsigned>)];
+	std::atomic<unsigned>	m_tail;
+};
+
+template<typename T, unsigned int CAPACITY>
+inline SpscRing<T, CAPACITY>::SpscRing():m_head(0)
+	,m_tail(0)
+{
+}
+
+template<typename T, unsigned int CAPACITY>
+inline bool SpscRing<T, CAPACITY>::push(const T& item)
+{
+	unsigned int tail = m_tail.load(std::memory_order_relaxed);
+	if (tail - m_head.load(std::memory_order_acquire) == CAPACITY)
+		return false;
+
+	m_items[tail & INDEX_MASK] = item;
+	m_tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+template<typename T, unsigned int CAPACITY>
+inline bool SpscRing<T, CAPACITY>::pop(T& item)
+{
+	unsigned int head = m_head.load(std::memory_order_relaxed);
+	if (head == m_tail.load(std::memory_order_acquire))
+		return false;
+
+	item = m_items[head & INDEX_MASK];
+	m_head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+template<typename T, unsigned int CAPACITY>
+inline bool SpscRing<T, CAPACITY>::isEmpty() const
+{
+	return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_acquire);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+
+//! Lock-free single producer / single consumer triple buffer.
+//!
+//! The producer fills getWriteBuffer() and publish()es it, the consumer calls
+//! update() to take the most recently published buffer and reads
+//! getReadBuffer(). Neither side ever waits for the other; buffers published
+//! while the consumer is busy are simply replaced by newer ones.
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer(T* first, T* second, T* third);
+
+	//producer side
+	T*		getWriteBuffer() const;
+	void	publish();
+
+	//consumer side
+	bool	update();
+	T*		getReadBuffer() const;
+
+private:
+	enum
+	{
+		INDEX_MASK = 0x3,
+		NEW_DATA = 0x4,
+	};
+
+	T*						m_buffers[3];
+	unsigned int			m_writeIndex;
+	unsigned int			m_readIndex;
+	std::atomic<unsigned>	m_middle;
+};
+
+template<typename T>
+inline TripleBuffer<T>::TripleBuffer(T* first, T* second, T* third):m_writeIndex(2)
+	,m_readIndex(0)
+	,m_middle(1)
+{
+	m_buffers[0] = first;
+	m_buffers[1] = second;
+	m_buffers[2] = third;
+}
+
+template<typename T>
+inline T* TripleBuffer<T>::getWriteBuffer() const
+{
+	return m_buffers[m_writeIndex];
+}
+
+template<typename T>
+inline void TripleBuffer<T>::publish()
+{
+	unsigned int previous = m_middle.exchange(m_writeIndex | NEW_DATA, std::memory_order_acq_rel);
+	m_writeIndex = previous & INDEX_MASK;
+}
+
+template<typename T>
+inline bool TripleBuffer<T>::update()
+{
+	if ((m_middle.load(std::memory_order_relaxed) & NEW_DATA) == 0)
+		return false;
+
+	unsigned int previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+	m_readIndex = previous & INDEX_MASK;
+	return true;
+}
+
+template<typename T>
+inline T* TripleBuffer<T>::getReadBuffer() const
+{
+	return m_buffers[m_readIndex];
+}
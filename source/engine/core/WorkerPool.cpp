@@ -0,0 +1,131 @@
+#include "WorkerPool.h"
+#if !defined(PTW32_VERSION)
+#include <unistd.h>
+#endif
+
+WorkerPool::WorkerPool(int threadCount):m_threads(nullptr)
+										,m_threadCount(threadCount > 0 ? threadCount : getProcessorCount())
+										,m_func(nullptr)
+										,m_context(nullptr)
+										,m_taskCount(0)
+										,m_nextTask(0)
+										,m_doneTasks(0)
+										,m_generation(0)
+										,m_quit(false)
+{
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_wakeCond, NULL);
+	pthread_cond_init(&m_doneCond, NULL);
+
+	// the calling thread is worker 0
+	if (m_threadCount > 1)
+	{
+		m_threads = new pthread_t[m_threadCount - 1];
+		for (int i=0; i<m_threadCount - 1; ++i)
+		{
+			pthread_create(&m_threads[i], NULL, &WorkerPool::_workerMain, this);
+		}
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_quit = true;
+	pthread_cond_broadcast(&m_wakeCond);
+	pthread_mutex_unlock(&m_mutex);
+
+	for (int i=0; i<m_threadCount - 1; ++i)
+	{
+		pthread_join(m_threads[i], NULL);
+	}
+	delete[] m_threads;
+
+	pthread_cond_destroy(&m_doneCond);
+	pthread_cond_destroy(&m_wakeCond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void WorkerPool::run(TaskFunc func, void* context, int taskCount)
+{
+	if (taskCount <= 0)
+		return;
+
+	if (m_threadCount <= 1 || taskCount == 1)
+	{
+		for (int i=0; i<taskCount; ++i)
+			func(context, i);
+		return;
+	}
+
+	pthread_mutex_lock(&m_mutex);
+	m_func = func;
+	m_context = context;
+	m_taskCount = taskCount;
+	m_nextTask = 0;
+	m_doneTasks = 0;
+	++m_generation;
+	pthread_cond_broadcast(&m_wakeCond);
+
+	this->_workLocked();
+
+	while (m_doneTasks < m_taskCount)
+	{
+		pthread_cond_wait(&m_doneCond, &m_mutex);
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+int WorkerPool::getProcessorCount()
+{
+#if defined(PTW32_VERSION)
+	int count = pthread_num_processors_np();
+#else
+	int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return count > 0 ? count : 1;
+}
+
+void* WorkerPool::_workerMain(void* param)
+{
+	WorkerPool* pool = reinterpret_cast<WorkerPool*>(param);
+	unsigned int seenGeneration = 0;
+
+	pthread_mutex_lock(&pool->m_mutex);
+	while (!pool->m_quit)
+	{
+		if (seenGeneration != pool->m_generation)
+		{
+			seenGeneration = pool->m_generation;
+			pool->_workLocked();
+		}
+		else
+		{
+			pthread_cond_wait(&pool->m_wakeCond, &pool->m_mutex);
+		}
+	}
+	pthread_mutex_unlock(&pool->m_mutex);
+
+	return NULL;
+}
+
+// Tasks are claimed under the lock and run outside of it. A worker that
+// wakes up late can only ever claim tasks of the job that is current.
+void WorkerPool::_workLocked()
+{
+	while (m_nextTask < m_taskCount)
+	{
+		int task = m_nextTask++;
+		TaskFunc func = m_func;
+		void* context = m_context;
+
+		pthread_mutex_unlock(&m_mutex);
+		func(context, task);
+		pthread_mutex_lock(&m_mutex);
+
+		if (++m_doneTasks == m_taskCount)
+		{
+			pthread_cond_broadcast(&m_doneCond);
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <pthread.h>
+
+//! Persistent pool of worker threads.
+//!
+//! run() hands out taskCount tasks to the workers and the calling thread and
+//! returns once every task has finished, so consecutive run() calls are
+//! separated by a full barrier. Threads sleep between calls.
+class WorkerPool
+{
+public:
+	typedef void (*TaskFunc)(void* context, int taskIndex);
+
+	//! threadCount includes the calling thread, 0 uses one thread per processor.
+	explicit WorkerPool(int threadCount = 0);
+	~WorkerPool();
+
+	void run(TaskFunc func, void* context, int taskCount);
+
+	int getThreadCount() const;
+
+	static int getProcessorCount();
+
+private:
+	static void* _workerMain(void* param);
+	void _workLocked();
+
+private:
+	pthread_t*			m_threads;
+	int					m_threadCount;
+
+	pthread_mutex_t		m_mutex;
+	pthread_cond_t		m_wakeCond;
+	pthread_cond_t		m_doneCond;
+
+	TaskFunc			m_func;
+	void*				m_context;
+	int					m_taskCount;
+	int					m_nextTask;
+	int					m_doneTasks;
+	unsigned int		m_generation;
+	bool				m_quit;
+};
+
+inline int
+WorkerPool::getThreadCount() const
+{
+	return m_threadCount;
+}
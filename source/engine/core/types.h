@@ -11,11 +11,17 @@ typedef signed short	s16;
 
 typedef unsigned int	u32;        
 typedef signed int		s32;        
+
+typedef unsigned long long	u64;
+typedef signed long long	s64;
+
 typedef float			f32;
 typedef double			f64;
 
 #define JENNY_STATIC_ASSERT(x) static_assert(x, #x)
 #define JENNY_ASSERT(x) assert(x)
-#define JENNY_DEBUG_BREAK_IF(x) assert(!x)
+#define JENNY_DEBUG_BREAK_IF(x) assert(!(x))
 
-#define isnan _isnan
\ No newline at end of file
+#if defined(_MSC_VER)
+#define isnan _isnan
+#endif
\ No newline at end of file
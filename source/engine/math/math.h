@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <algorithm>
 #include <limits>
 #include <core/types.h>
 #include <type_traits>
@@ -136,7 +137,7 @@ inline T Log(T x) {
 
 template <typename T>
 inline T Log10(T x) {
-	return glf::Log(x) / glf::Log(T(10));
+	return jenny::Log(x) / jenny::Log(T(10));
 }
 
 inline int Log10(int x) {
@@ -171,7 +172,7 @@ minmax_(const T& a, const T& b, const T& c, T& theMin, T& theMax)
 		if(a < c) // a < b, a < c
 		{
 			theMin = a;
-			theMax = max_(b, c);
+			theMax = std::max(b, c);
 		}
 		else // c <= a < b
 		{
@@ -181,7 +182,7 @@ minmax_(const T& a, const T& b, const T& c, T& theMin, T& theMax)
 	}
 	else if(c < a) // b <= a, c < a
 	{
-		theMin = min_(b, c);
+		theMin = std::min(b, c);
 		theMax = a;
 	}
 	else // b <= a <= c
@@ -304,7 +305,7 @@ inline
 s32
 floor32(const F& v)
 {
-	return s32(glf::Floor(v));
+	return s32(jenny::Floor(v));
 }
 
 template < typename F >
@@ -312,7 +313,7 @@ inline
 s32
 ceil32(const F& v)
 {
-	return s32(glf::Ceil(v));
+	return s32(jenny::Ceil(v));
 }
 
 template < typename F >
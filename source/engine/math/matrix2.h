@@ -383,7 +383,7 @@ inline
 bool
 CMatrix2<T>::getInverse(CMatrix2& out) const
 {
-	GLITCH_ASSERT(this != &out);
+	JENNY_ASSERT(this != &out);
 
 	double det = getDeterminant();
 
@@ -463,7 +463,7 @@ inline
 void
 CMatrix2<T>::getTransposed(CMatrix2& o) const
 {
-	GLITCH_ASSERT(this != &o);
+	JENNY_ASSERT(this != &o);
 	
 	o[0] = (*this)[0];
 	o[1] = (*this)[2];
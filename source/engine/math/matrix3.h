@@ -341,7 +341,7 @@ inline
 CMatrix3<T>
 CMatrix3<T>::operator * (const CMatrix3& other) const
 {
-	CMatrix3 result(ECT_NOTHING);
+	CMatrix3 result;
 	result.M[0] = M[0] * other.M[0] + M[3] * other.M[1] + M[6] * other.M[2];
 	result.M[1] = M[1] * other.M[0] + M[4] * other.M[1] + M[7] * other.M[2];
 	result.M[2] = M[2] * other.M[0] + M[5] * other.M[1] + M[8] * other.M[2];
@@ -550,7 +550,7 @@ inline
 vector2d<T>
 CMatrix3<T>::getScale() const
 {
-	vector2d<T> vScale(ECT_NOTHING);
+	vector2d<T> vScale;
 	vScale.setX(vector2d<T>((*this)[0], (*this)[1]).getLength());
 	vScale.setY(vector2d<T>((*this)[3], (*this)[4]).getLength());
 	return vScale;
@@ -577,8 +577,8 @@ inline
 CMatrix3<T>&
 CMatrix3<T>::setRotationRadians(T rotation)
 {
-    const f64 cr = glf::Cos(f64(rotation));
-	const f64 sr = glf::Sin(f64(rotation));
+    const f64 cr = jenny::Cos(f64(rotation));
+	const f64 sr = jenny::Sin(f64(rotation));
 	(*this)[0] = T(cr);
 	(*this)[1] = T(sr);
 	(*this)[3] = T(-sr);
@@ -613,7 +613,7 @@ CMatrix3<T>::getRotationDegrees() const
 {
 	const CMatrix3<T>& mat = *this;
 
-	f64 r = glf::Atan2(f64(M[1]), f64(M[0])) * RADTODEG64;
+	f64 r = jenny::Atan2(f64(M[1]), f64(M[0])) * RADTODEG64;
 	if(r < 0.0)
 	{
 		r += 360.0;
@@ -738,7 +738,7 @@ inline
 void
 CMatrix3<T>::transformPlane(const plane3d<T>& in, plane3d<T>& out) const
 {
-	vector3d<T> member(ECT_NOTHING);
+	vector3d<T> member;
 	transformVect(member, in.getMemberPoint());
 			
 	transformVect(out.Normal, in.Normal);
@@ -824,7 +824,7 @@ inline
 bool
 CMatrix3<T>::getInverse(CMatrix3& out) const
 {
-	GLITCH_ASSERT(this != &out);
+	JENNY_ASSERT(this != &out);
 
 	// Cramer's rule.
 	double t0 = double((*this)[4] * (*this)[8] - (*this)[7] * (*this)[5]);
@@ -869,7 +869,7 @@ inline
 bool
 CMatrix3<T>::makeInverse()
 {
-	CMatrix3 temp(ECT_NOTHING);
+	CMatrix3 temp;
 	if(getInverse(temp))
 	{
 		*this = temp;
@@ -918,7 +918,7 @@ inline
 CMatrix3<T>
 CMatrix3<T>::getTransposed() const
 {
-	CMatrix3<T> t(ECT_NOTHING);
+	CMatrix3<T> t;
 	getTransposed(t);
 	return t;
 }
@@ -928,7 +928,7 @@ inline
 void
 CMatrix3<T>::getTransposed(CMatrix3& o) const
 {
-	GLITCH_ASSERT(this != &o);
+	JENNY_ASSERT(this != &o);
 	
 	o[0] = (*this)[0];
 	o[1] = (*this)[3];
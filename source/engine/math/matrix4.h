@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string.h>
 #include <core/types.h>
 #include <math/vector4d.h>
 #include <math/matrix3.h>
@@ -733,7 +734,7 @@ inline
 vector3d<T>
 CMatrix4<T>::getScale() const
 {
-	vector3d<T> vScale(ECT_NOTHING);
+	vector3d<T> vScale;
 	vScale.setX(vector3d<T>((*this)[0], (*this)[1], (*this)[2]).getLength());
 	vScale.setY(vector3d<T>((*this)[4], (*this)[5], (*this)[6]).getLength());
 	vScale.setZ(vector3d<T>((*this)[8], (*this)[9], (*this)[10]).getLength());
@@ -761,12 +762,12 @@ inline
 CMatrix4<T>&
 CMatrix4<T>::setRotationRadians(const vector3d<T>& rotation)
 {
-    const f64 cr = glf::Cos(f64(rotation.getX()));
-	const f64 sr = glf::Sin(f64(rotation.getX()));
-	const f64 cp = glf::Cos(f64(rotation.getY()));
-	const f64 sp = glf::Sin(f64(rotation.getY()));
-	const f64 cy = glf::Cos(f64(rotation.getZ()));
-	const f64 sy = glf::Sin(f64(rotation.getZ()));
+    const f64 cr = jenny::Cos(f64(rotation.getX()));
+	const f64 sr = jenny::Sin(f64(rotation.getX()));
+	const f64 cp = jenny::Cos(f64(rotation.getY()));
+	const f64 sp = jenny::Sin(f64(rotation.getY()));
+	const f64 cy = jenny::Cos(f64(rotation.getZ()));
+	const f64 sy = jenny::Sin(f64(rotation.getZ()));
 			
 	(*this)[0] = T(cp * cy);
 	(*this)[1] = T(cp * sy);
@@ -852,12 +853,12 @@ inline
 CMatrix4<T>&
 CMatrix4<T>::setInverseRotationRadians(const vector3d<T>& rotation)
 {
-	f64 cr = glf::Cos(rotation.getX());
-	f64 sr = glf::Sin(rotation.getX());
-	f64 cp = glf::Cos(rotation.getY());
-	f64 sp = glf::Sin(rotation.getY());
-	f64 cy = glf::Cos(rotation.getZ());
-	f64 sy = glf::Sin(rotation.getZ());
+	f64 cr = jenny::Cos(rotation.getX());
+	f64 sr = jenny::Sin(rotation.getX());
+	f64 cp = jenny::Cos(rotation.getY());
+	f64 sp = jenny::Sin(rotation.getY());
+	f64 cy = jenny::Cos(rotation.getZ());
+	f64 sy = jenny::Sin(rotation.getZ());
 			
 	(*this)[0] = T(cp * cy);
 	(*this)[4] = T(cp * sy);
@@ -1101,10 +1102,10 @@ inline
 void
 CMatrix4<T>::transformPlane(plane3d<T>& plane) const
 {
-	vector3d<T> member(ECT_NOTHING);
+	vector3d<T> member;
 	transformVect(member, plane.getMemberPoint());
 			
-	vector3d<T> origin(ECT_NOTHING);
+	vector3d<T> origin;
 	transformVect(plane.Normal);
 	transformVect(origin);
 			
@@ -1118,7 +1119,7 @@ void
 CMatrix4<T>::transformPlane_new(plane3d<T>& plane) const
 {
 	// rotate normal -> rotateVect ( plane.n );
-	vector3d<T> n(ECT_NOTHING);
+	vector3d<T> n;
 	n.setX(plane.Normal.getX() * (*this)[0] + plane.Normal.getY() * (*this)[4] + plane.Normal.getZ() * (*this)[8]);
 	n.setY(plane.Normal.getX() * (*this)[1] + plane.Normal.getY() * (*this)[5] + plane.Normal.getZ() * (*this)[9]);
 	n.setZ(plane.Normal.getX() * (*this)[2] + plane.Normal.getY() * (*this)[6] + plane.Normal.getZ() * (*this)[10]);
@@ -1488,8 +1489,8 @@ inline
 CMatrix4<T>&
 CMatrix4<T>::setTextureRotationCenter(T rotateRad)
 {
-	const float c = glf::Cos(float(rotateRad));
-	const float s = glf::Sin(float(rotateRad));
+	const float c = jenny::Cos(float(rotateRad));
+	const float s = jenny::Sin(float(rotateRad));
 	(*this)[0] = T(c);
 	(*this)[1] = T(s);
 			
@@ -100,7 +100,7 @@ inline
 CMatrix4<T>&
 buildProjectionMatrixPerspectiveFovInfinity(CMatrix4<T>& out, T fieldOfViewRadians, T aspectRatio, T zNear)
 {
-	f64 h = 1.0 / glf::Tan(f64(fieldOfViewRadians) / 2.0);
+	f64 h = 1.0 / jenny::Tan(f64(fieldOfViewRadians) / 2.0);
 	T w = T(h / f64(aspectRatio));
 
 	out(0, 0) = w;
@@ -495,8 +495,8 @@ buildTextureTransform(T rotateRad,
 					  const vector2d<T>& translate,
 					  const vector2d<T>& scale)
 {
-	T c = glf::Cos(rotateRad);
-	T s = glf::Sin(rotateRad);
+	T c = jenny::Cos(rotateRad);
+	T s = jenny::Sin(rotateRad);
 
 	CMatrix4<T> m(CMatrix4<T>::EM4CONST_NOTHING);
 
@@ -690,7 +690,7 @@ inline
 void
 rowMatrixProduct34(MT1& out, const MT2& m1, const MT3& m2)
 {
-	//GLITCH_DEBUG_BREAK_IF(&out == &m1 || &out == &m2);
+	//JENNY_DEBUG_BREAK_IF(&out == &m1 || &out == &m2);
 	out[0] = m1[0] * m2[0] + m1[4] * m2[1] + m1[8] * m2[2];
 	out[1] = m1[1] * m2[0] + m1[5] * m2[1] + m1[9] * m2[2];
 	out[2] = m1[2] * m2[0] + m1[6] * m2[1] + m1[10] * m2[2];
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <core/types.h>
+#include <math/math.h>
 #include <shape/dimension2d.h>
 
 namespace jenny
@@ -610,7 +611,7 @@ inline
 bool
 vector2d<T>::equals(const vector2d<T>& other) const
 {
-	return core::equals((*this)[0], other[0]) && core::equals((*this)[1], other[1]);
+	return jenny::equals((*this)[0], other[0]) && jenny::equals((*this)[1], other[1]);
 }
 
 template < typename T >
@@ -634,8 +635,8 @@ inline
 T
 vector2d<T>::getLength() const
 {
-	typedef typename boost::mpl::if_<boost::mpl::not_<boost::is_floating_point<T> >, float, T>::type TCast;
-	return T(glf::Sqrt(TCast(getLengthSQ())));
+	typedef typename std::conditional<std::is_floating_point<T>::value, T, float>::type TCast;
+	return T(jenny::Sqrt(TCast(getLengthSQ())));
 }
 
 template < typename T >
@@ -668,8 +669,8 @@ vector2d<T>&
 vector2d<T>::rotateBy(f64 degrees, const vector2d<T>& center)
 {
 	degrees *= DEGTORAD64;
-	const T cs = T(glf::Cos(degrees));
-	const T sn = T(glf::Sin(degrees));
+	const T cs = T(jenny::Cos(degrees));
+	const T sn = T(jenny::Sin(degrees));
 
 	(*this) -= center;
 	set((*this)[0] * cs - (*this)[1] * sn, (*this)[0] * sn + (*this)[1] * cs);
@@ -708,15 +709,15 @@ vector2d<T>::getAngleTrig() const
 	{
 		if((*this)[0] > T(0))
 		{
-			return glf::Atan(f64((*this)[1]) / f64((*this)[0])) * RADTODEG64;
+			return jenny::Atan(f64((*this)[1]) / f64((*this)[0])) * RADTODEG64;
 		}
-		return 180.0 - glf::Atan(f64((*this)[1]) / -f64((*this)[0])) * RADTODEG64;
+		return 180.0 - jenny::Atan(f64((*this)[1]) / -f64((*this)[0])) * RADTODEG64;
 	}
 	if((*this)[0] > T(0))
 	{
-		return 360.0 - glf::Atan(-f64((*this)[1]) / f64((*this)[0])) * RADTODEG64;
+		return 360.0 - jenny::Atan(-f64((*this)[1]) / f64((*this)[0])) * RADTODEG64;
 	}
-	return 180.0 + glf::Atan(-f64((*this)[1]) / -f64((*this)[0])) * RADTODEG64;
+	return 180.0 + jenny::Atan(-f64((*this)[1]) / -f64((*this)[0])) * RADTODEG64;
 }
 
 template < typename T >
@@ -734,7 +735,7 @@ vector2d<T>::getAngle() const
 	}
 
 	f64 tmp = f64((*this)[1]) / f64(getLength());
-	tmp = glf::Atan(glf::Sqrt(1.0 - tmp * tmp) / tmp) * RADTODEG64;
+	tmp = jenny::Atan(jenny::Sqrt(1.0 - tmp * tmp) / tmp) * RADTODEG64;
 
 	if((*this)[0] > T(0) && (*this)[1] > T(0))
 	{
@@ -767,7 +768,7 @@ vector2d<T>::getAngleWith(const vector2d<T>& b) const
 		return 90.0;
 	}
 
-	return glf::SafeAcos(tmp / (f64(getLength()) * f64(b.getLength()))) * RADTODEG64;
+	return jenny::SafeAcos(tmp / (f64(getLength()) * f64(b.getLength()))) * RADTODEG64;
 }
 
 template < typename T >
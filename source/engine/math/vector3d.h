@@ -479,7 +479,7 @@ inline
 T&
 vector3d<T>::operator [] (u32 i)
 {
-	GLITCH_DEBUG_BREAK_IF(i >= 3);
+	JENNY_DEBUG_BREAK_IF(i >= 3);
 	return getDataPtr()[i];
 }
 
@@ -488,7 +488,7 @@ inline
 const T&
 vector3d<T>::operator [] (u32 i) const
 {
-	GLITCH_DEBUG_BREAK_IF(i >= 3);
+	JENNY_DEBUG_BREAK_IF(i >= 3);
 	return getDataPtr()[i];
 }
 
@@ -730,9 +730,9 @@ inline
 bool
 vector3d<T>::equals(const vector3d<T>& other, const T tolerance) const
 {
-	return (core::equals(Data[0], other.Data[0], tolerance)
-			&& core::equals(Data[1], other.Data[1], tolerance)
-			&& core::equals(Data[2], other.Data[2], tolerance));
+	return (jenny::equals(Data[0], other.Data[0], tolerance)
+			&& jenny::equals(Data[1], other.Data[1], tolerance)
+			&& jenny::equals(Data[2], other.Data[2], tolerance));
 }
 
 template < typename T >
@@ -756,8 +756,8 @@ inline
 T
 vector3d<T>::getLength() const
 {
-	typedef typename boost::mpl::if_<boost::mpl::not_<boost::is_floating_point<T> >, float, T>::type TCast;
-	return T(glf::Sqrt(TCast(getLengthSQ())));
+	typedef typename std::conditional<std::is_floating_point<T>::value, T, float>::type TCast;
+	return T(jenny::Sqrt(TCast(getLengthSQ())));
 }
 
 template < typename T >
@@ -809,7 +809,7 @@ inline
 u32
 vector3d<T>::getMinorAxis() const
 {
-	const T absData[3] = {glf::Abs(Data[0]), glf::Abs(Data[1]), glf::Abs(Data[2])};
+	const T absData[3] = {std::abs(Data[0]), std::abs(Data[1]), std::abs(Data[2])};
 	return (absData[0] < absData[1]
 			? (absData[0] < absData[2]
 			   ? 0
@@ -824,7 +824,7 @@ inline
 u32
 vector3d<T>::getMajorAxis() const
 {
-	const T absData[3] = {glf::Abs(Data[0]), glf::Abs(Data[1]), glf::Abs(Data[2])};
+	const T absData[3] = {std::abs(Data[0]), std::abs(Data[1]), std::abs(Data[2])};
 	return (absData[0] > absData[1]
 			? (absData[0] > absData[2]
 			   ? 0
@@ -890,8 +890,8 @@ vector3d<T>&
 vector3d<T>::rotateXZBy(f64 degrees, const vector3d<T>& center)
 {
 	degrees *= DEGTORAD64;
-	T cs = T(glf::Cos(degrees));
-	T sn = T(glf::Sin(degrees));
+	T cs = T(jenny::Cos(degrees));
+	T sn = T(jenny::Sin(degrees));
 	Data[0] -= center[0];
 	Data[2] -= center[2];
 	set(Data[0] * cs - Data[2] * sn, Data[1], Data[0] * sn + Data[2] * cs);
@@ -906,8 +906,8 @@ vector3d<T>&
 vector3d<T>::rotateXYBy(f64 degrees, const vector3d<T>& center)
 {
 	degrees *= DEGTORAD64;
-	T cs = T(glf::Cos(degrees));
-	T sn = T(glf::Sin(degrees));
+	T cs = T(jenny::Cos(degrees));
+	T sn = T(jenny::Sin(degrees));
 	Data[0] -= center[0];
 	Data[1] -= center[1];
 	set(Data[0] * cs - Data[1] * sn, Data[0] * sn + Data[1] * cs, Data[2]);
@@ -922,8 +922,8 @@ vector3d<T>&
 vector3d<T>::rotateYZBy(f64 degrees, const vector3d<T>& center)
 {
 	degrees *= DEGTORAD64;
-	T cs = T(glf::Cos(degrees));
-	T sn = T(glf::Sin(degrees));
+	T cs = T(jenny::Cos(degrees));
+	T sn = T(jenny::Sin(degrees));
 	Data[2] -= center[2];
 	Data[1] -= center[1];
 	set(Data[0], Data[1] * cs - Data[2] * sn, Data[1] * sn + Data[2] * cs);
@@ -961,7 +961,7 @@ vector3d<T>::getHorizontalAngle() const
 {
 	vector3d<T> angle;
 
-	angle[1] = T(glf::Atan2(f64(Data[0]), f64(Data[2])) * RADTODEG64);
+	angle[1] = T(jenny::Atan2(f64(Data[0]), f64(Data[2])) * RADTODEG64);
 
 	if(angle[1] < T(0))
 	{
@@ -972,9 +972,9 @@ vector3d<T>::getHorizontalAngle() const
 		angle[1] -= T(360);
 	}
 
-	const f64 z1 = glf::Sqrt(f64(Data[0]) * f64(Data[0]) + f64(Data[2]) * f64(Data[2]));
+	const f64 z1 = jenny::Sqrt(f64(Data[0]) * f64(Data[0]) + f64(Data[2]) * f64(Data[2]));
 
-	angle[0] = T(glf::Atan2(z1, f64(Data[1])) * RADTODEG64 - 90.0);
+	angle[0] = T(jenny::Atan2(z1, f64(Data[1])) * RADTODEG64 - 90.0);
 
 	if(angle[0] < T(0))
 	{
@@ -993,12 +993,12 @@ inline
 vector3d<T>
 vector3d<T>::rotationToDirection(const vector3d<T> & forwards) const
 {
-	const f64 cr = glf::Cos(DEGTORAD64 * f64(Data[0]));
-	const f64 sr = glf::Sin(DEGTORAD64 * f64(Data[0]));
-	const f64 cp = glf::Cos(DEGTORAD64 * f64(Data[1]));
-	const f64 sp = glf::Sin(DEGTORAD64 * f64(Data[1]));
-	const f64 cy = glf::Cos(DEGTORAD64 * f64(Data[2]));
-	const f64 sy = glf::Sin(DEGTORAD64 * f64(Data[2]));
+	const f64 cr = jenny::Cos(DEGTORAD64 * f64(Data[0]));
+	const f64 sr = jenny::Sin(DEGTORAD64 * f64(Data[0]));
+	const f64 cp = jenny::Cos(DEGTORAD64 * f64(Data[1]));
+	const f64 sp = jenny::Sin(DEGTORAD64 * f64(Data[1]));
+	const f64 cy = jenny::Cos(DEGTORAD64 * f64(Data[2]));
+	const f64 sy = jenny::Sin(DEGTORAD64 * f64(Data[2]));
 
 	const f64 srsp = sr * sp;
 	const f64 crsp = cr * sp;
@@ -1025,9 +1025,9 @@ vector3d<T>
 vector3d<T>::clip(const vector3d& min, const vector3d& max) const
 {
 	return vector3d<T>(
-		glf::Clamp(getX(), min.getX(), max.getX()),
-		glf::Clamp(getY(), min.getY(), max.getY()),
-		glf::Clamp(getZ(), min.getZ(), max.getZ()));
+		jenny::Clamp(getX(), min.getX(), max.getX()),
+		jenny::Clamp(getY(), min.getY(), max.getY()),
+		jenny::Clamp(getZ(), min.getZ(), max.getZ()));
 }
 
 template < typename T >
@@ -1035,9 +1035,9 @@ inline
 vector3d<T>&
 vector3d<T>::abs()
 {
-	Data[0] = glf::Abs(Data[0]);
-	Data[1] = glf::Abs(Data[1]);
-	Data[2] = glf::Abs(Data[2]);
+	Data[0] = std::abs(Data[0]);
+	Data[1] = std::abs(Data[1]);
+	Data[2] = std::abs(Data[2]);
 	return *this;
 }
 
@@ -57,17 +57,17 @@ public:
 	template < typename T2 >
 	explicit vector4d(const vector3d<T2>& xyz, T w = T(0))
 	{
-			(*this)[0] = other.getX();
-			(*this)[1] = other.getY();
-			(*this)[2] = other.getZ();
+			(*this)[0] = xyz.getX();
+			(*this)[1] = xyz.getY();
+			(*this)[2] = xyz.getZ();
 			(*this)[3] = w;
 	}
 
 	template < typename T2 >
 	explicit vector4d(const vector2d<T2>& xy, T z = T(0), T w = T(0))
 	{
-			(*this)[0] = other.getX();
-			(*this)[1] = other.getY();
+			(*this)[0] = xy.getX();
+			(*this)[1] = xy.getY();
 			(*this)[2] = z;
 			(*this)[3] = w;
 	}
@@ -364,10 +364,10 @@ public:
 	bool equals(const vector4d& other,
 		const T tolerance = T(ROUNDING_ERROR_32)) const
 	{
-		return (core::equals(this->getX(), other.getX(), tolerance) &&
-			core::equals(this->getY(), other.getY(), tolerance) &&
-			core::equals(this->getZ(), other.getZ(), tolerance) &&
-			core::equals(this->getW(), other.getW(), tolerance));
+		return (jenny::equals(this->getX(), other.getX(), tolerance) &&
+			jenny::equals(this->getY(), other.getY(), tolerance) &&
+			jenny::equals(this->getZ(), other.getZ(), tolerance) &&
+			jenny::equals(this->getW(), other.getW(), tolerance));
 	}
 
 	vector3d<T> getXYZ() const
@@ -458,8 +458,8 @@ public:
 	void rotateXZBy(f64 degrees, const vector3d<T>& center = vector3d<T>())
 	{
 		degrees *= DEGTORAD64;
-		T cs = (T)glf::Cos(degrees);
-		T sn = (T)glf::Sin(degrees);
+		T cs = (T)jenny::Cos(degrees);
+		T sn = (T)jenny::Sin(degrees);
 		this->setX(this->getX() - center.getX());
 		this->setZ(this->getZ() - center.getZ());
 		set(this->getX() * cs - this->getZ() * sn, this->getY(), this->getX() * sn + this->getZ() * cs);
@@ -473,8 +473,8 @@ public:
 	void rotateXYBy(f64 degrees, const vector3d<T>& center = vector3d<T>())
 	{
 		degrees *= DEGTORAD64;
-		T cs = (T)glf::Cos(degrees);
-		T sn = (T)glf::Sin(degrees);
+		T cs = (T)jenny::Cos(degrees);
+		T sn = (T)jenny::Sin(degrees);
 		this->setX(this->getX() - center.getX());
 		this->setY(this->getY() - center.getY());
 		set(this->getX() * cs - this->getY() * sn, this->getX() * sn + this->getY() * cs, this->getZ());
@@ -488,8 +488,8 @@ public:
 	void rotateYZBy(f64 degrees, const vector3d<T>& center = vector3d<T>())
 	{
 		degrees *= DEGTORAD64;
-		T cs = (T)glf::Cos(degrees);
-		T sn = (T)glf::Sin(degrees);
+		T cs = (T)jenny::Cos(degrees);
+		T sn = (T)jenny::Sin(degrees);
 		this->setZ(this->getZ() - center.getZ());
 		this->setY(this->getY() - center.getY());
 		set(this->getX(), this->getY() * cs - this->getZ() * sn, this->getY() * sn + this->getZ() * cs);
@@ -54,7 +54,7 @@ computeBoundingBox(const T* pos,
 	}
 	else
 	{
-		aabb.MinEdge = aabb.MaxEdge = core::vector3d<T>();
+		aabb.MinEdge = aabb.MaxEdge = jenny::vector3d<T>();
 	}
 }
 
@@ -117,7 +117,7 @@ computeBoundingBoxWithTransformation(const T* pos,
 	}
 	else
 	{
-		aabb.MinEdge = aabb.MaxEdge = core::vector3d<T>();
+		aabb.MinEdge = aabb.MaxEdge = jenny::vector3d<T>();
 	}
 }
 
@@ -182,7 +182,7 @@ intersectAAPlane(const VECTOR& p0,
 				 typename VECTOR::SValueType pos)
 {
 	const typename VECTOR::SValueType d = p1[axis] - p0[axis];
-	if(glf::Abs(d) < core::ROUNDING_ERROR_32)
+	if(std::abs(d) < jenny::ROUNDING_ERROR_32)
 	{
 		return p0;
 	}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <limits>
+#include <algorithm>
 #include <stddef.h>
 #include <type_traits>
 #include <math/math.h>
@@ -338,12 +339,12 @@ aabbox3d<T>::intersectsWithBox(const aabbox3d<T>& other, aabbox3d<T>& result) co
 	if (intersect)
 	{
 		// On each axis, compute maximum of minimums and minimums of maximums
-		result.MinEdge = core::vector3d<T>(	std::max(MinEdge.getX(), other.MinEdge.getX()),
+		result.MinEdge = jenny::vector3d<T>(	std::max(MinEdge.getX(), other.MinEdge.getX()),
 											std::max(MinEdge.getY(), other.MinEdge.getY()),
 											std::max(MinEdge.getZ(), other.MinEdge.getZ())
 										);
 
-		result.MaxEdge = core::vector3d<T>( std::min(MaxEdge.getX(), other.MaxEdge.getX()),
+		result.MaxEdge = jenny::vector3d<T>( std::min(MaxEdge.getX(), other.MaxEdge.getX()),
 											std::min(MaxEdge.getY(), other.MaxEdge.getY()),
 											std::min(MaxEdge.getZ(), other.MaxEdge.getZ())
 										);
@@ -375,13 +376,13 @@ aabbox3d<T>::intersectsWithBoxEx(const aabbox3d<T>& other) const
 {
 	if(isFullInside(other))
 	{
-		return scene::ECR_INSIDE;
+		return ECR_INSIDE;
 	}
 	if(intersectsWithBox(other))
 	{
-		return scene::ECR_INTERSECT;
+		return ECR_INTERSECT;
 	}
-	return scene::ECR_OUTSIDE;
+	return ECR_OUTSIDE;
 }
 
 template < typename T >
@@ -490,7 +491,7 @@ aabbox3d<T>::intersectsWithRay(const vector3d<T>& origin,
 		{
 			// this if will disappear because the condition value is known at
 			// compile-time
-			if(boost::is_floating_point<T>::value)
+			if(std::is_floating_point<T>::value)
 			{
 				f = T(1) / f;
 				t1 = e1 * f;
@@ -503,7 +504,7 @@ aabbox3d<T>::intersectsWithRay(const vector3d<T>& origin,
 			}
 			if(t1 > t2)
 			{
-				boost::swap(t1, t2);
+				std::swap(t1, t2);
 			}
 			if(t1 > tmin)
 			{
@@ -595,7 +596,7 @@ inline
 u32
 aabbox3d<T>::getMaxExtentAxis() const
 {
-	vector3d<T> extent(ECT_NOTHING);
+	vector3d<T> extent;
 	return getMaxExtentAxis(extent);
 }
 
@@ -620,8 +621,8 @@ inline
 void
 aabbox3d<T>::getEdges(vector3d<T>* edges) const
 {
-	const core::vector3d<T> middle = getCenter();
-	const core::vector3d<T> diag = middle - MaxEdge;
+	const jenny::vector3d<T> middle = getCenter();
+	const jenny::vector3d<T> diag = middle - MaxEdge;
 
 	/*
 	  Edges are stored in this way:
@@ -650,8 +651,8 @@ inline
 void
 aabbox3d<T>::getEdges(vector3d<T>* edges, ptrdiff_t stride) const
 {
-	const core::vector3d<T> middle = getCenter();
-	const core::vector3d<T> diag = middle - MaxEdge;
+	const jenny::vector3d<T> middle = getCenter();
+	const jenny::vector3d<T> diag = middle - MaxEdge;
 
 	/*
 	  Edges are stored in this way:
@@ -665,15 +666,14 @@ aabbox3d<T>::getEdges(vector3d<T>* edges, ptrdiff_t stride) const
 	  0---------4/
 	*/
 
-	util::SStridedIterator<vector3d<T> > iter(edges, stride);
-	(iter++)->set(middle.getX() + diag.getX(), middle.getY() + diag.getY(), middle.getZ() + diag.getZ());
-	(iter++)->set(middle.getX() + diag.getX(), middle.getY() - diag.getY(), middle.getZ() + diag.getZ());
-	(iter++)->set(middle.getX() + diag.getX(), middle.getY() + diag.getY(), middle.getZ() - diag.getZ());
-	(iter++)->set(middle.getX() + diag.getX(), middle.getY() - diag.getY(), middle.getZ() - diag.getZ());
-	(iter++)->set(middle.getX() - diag.getX(), middle.getY() + diag.getY(), middle.getZ() + diag.getZ());
-	(iter++)->set(middle.getX() - diag.getX(), middle.getY() - diag.getY(), middle.getZ() + diag.getZ());
-	(iter++)->set(middle.getX() - diag.getX(), middle.getY() + diag.getY(), middle.getZ() - diag.getZ());
-	iter->set(middle.getX() - diag.getX(), middle.getY() - diag.getY(), middle.getZ() - diag.getZ());
+	//bit 0 of the edge index flips y, bit 1 flips z and bit 2 flips x
+	for (int i=0; i<8; ++i)
+	{
+		vector3d<T>* edge = reinterpret_cast<vector3d<T>*>(reinterpret_cast<u8*>(edges) + i*stride);
+		edge->set(middle.getX() + ((i & 4) ? -diag.getX() : diag.getX()),
+				  middle.getY() + ((i & 1) ? -diag.getY() : diag.getY()),
+				  middle.getZ() + ((i & 2) ? -diag.getZ() : diag.getZ()));
+	}
 }
 
 template < typename T >
@@ -691,15 +691,15 @@ aabbox3d<T>::repair()
 {
 	if(MinEdge.getX() > MaxEdge.getX())
 	{
-		boost::swap(MinEdge[0], MaxEdge[0]);
+		std::swap(MinEdge[0], MaxEdge[0]);
 	}
 	if(MinEdge.getY() > MaxEdge.getY())
 	{
-		boost::swap(MinEdge[1], MaxEdge[1]);
+		std::swap(MinEdge[1], MaxEdge[1]);
 	}
 	if(MinEdge.getZ() > MaxEdge.getZ())
 	{
-		boost::swap(MinEdge[2], MaxEdge[2]);
+		std::swap(MinEdge[2], MaxEdge[2]);
 	}
 }
 
@@ -764,9 +764,9 @@ T
 aabbox3d<T>::getMaxDistanceSQ(const vector3d<T>& p) const
 {
 	vector3d<T> res(
-		core::max_(std::abs(MinEdge.getX() - p.getX()), std::abs(MaxEdge.getX() - p.getX())),
-		core::max_(std::abs(MinEdge.getY() - p.getY()), std::abs(MaxEdge.getY() - p.getY())),
-		core::max_(std::abs(MinEdge.getZ() - p.getZ()), std::abs(MaxEdge.getZ() - p.getZ())));
+		std::max(std::abs(MinEdge.getX() - p.getX()), std::abs(MaxEdge.getX() - p.getX())),
+		std::max(std::abs(MinEdge.getY() - p.getY()), std::abs(MaxEdge.getY() - p.getY())),
+		std::max(std::abs(MinEdge.getZ() - p.getZ()), std::abs(MaxEdge.getZ() - p.getZ())));
 
 	return res.getLengthSQ();
 		
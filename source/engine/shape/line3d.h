@@ -243,7 +243,7 @@ line3d<T>::getIntersectionWithSphere(vector3d<T> sorigin, T sradius, f64& outdis
 	{
 		return false;
 	}
-	outdistance = f64(v) - glf::Sqrt(f64(d));
+	outdistance = f64(v) - jenny::Sqrt(f64(d));
 	return true;
 }
 
@@ -253,9 +253,9 @@ inline
 void
 line3d<T>::getClosestPoints(const line3d<T>& line, vector3d<T>& pt0, vector3d<T>& pt1) const
 {
-    core::vector3d<T> u = End - Start;
-    core::vector3d<T> v = line.End - line.Start;
-    core::vector3d<T> w = Start - line.Start;
+    jenny::vector3d<T> u = End - Start;
+    jenny::vector3d<T> v = line.End - line.Start;
+    jenny::vector3d<T> w = Start - line.Start;
 
     const T a = u.dotProduct(u);
     const T b = u.dotProduct(v);
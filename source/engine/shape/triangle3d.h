@@ -441,7 +441,7 @@ triangle3d<T>::intersectsWithBoxWithoutBoxTest(const aabbox3d<T>& aabb) const
 	p1 = e[j][ea] * v[v1][va] - e[j][eb] * v[v1][vb]; \
 	if(p1 < p0) \
 	{ \
-		boost::swap(p0, p1); \
+		std::swap(p0, p1); \
 	} \
 	r = absE[ea] * h[va] + absE[eb] * h[vb]; \
 	if(p0 > r || p1 < -r) \
@@ -454,7 +454,7 @@ triangle3d<T>::intersectsWithBoxWithoutBoxTest(const aabbox3d<T>& aabb) const
 	p1 = e[j][eb] * v[v1][vb] - e[j][ea] * v[v1][va]; \
 	if(p1 < p0) \
 	{ \
-		boost::swap(p0, p1); \
+		std::swap(p0, p1); \
 	} \
 	r = absE[ea] * h[va] + absE[eb] * h[vb]; \
 	if(p0 > r || p1 < -r) \
@@ -0,0 +1,154 @@
+#include "DropStamp.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+//drops write heights in the range of the original 8 bit height maps
+static const int MAX_DROP_HEIGHT = 127;
+
+DropStamp::DropStamp(int left, int top, int width, int height):m_left(left)
+	,m_top(top)
+	,m_width(width)
+	,m_height(height)
+{
+}
+
+DropStamp* DropStamp::CreateRadial(int radius, int depth)
+{
+	DropStamp* stamp = new DropStamp(-radius, -radius, 2*radius, 2*radius);
+
+	std::vector<int> row(stamp->m_width);
+	for (int j=0; j<stamp->m_height; ++j)
+	{
+		int dy = j - radius;
+		for (int i=0; i<stamp->m_width; ++i)
+		{
+			int dx = i - radius;
+			int dist = dx*dx + dy*dy;
+			if (dist < radius*radius)
+				row[i] = (int)((float)depth * ((float)(radius - sqrt((float)dist))/(float)radius));
+			else
+				row[i] = NO_HEIGHT;
+		}
+		stamp->_addRow(j, &row[0]);
+	}
+	return stamp;
+}
+
+DropStamp* DropStamp::CreateEllipse(int radiusX, int radiusY, int depth)
+{
+	DropStamp* stamp = new DropStamp(-radiusX, -radiusY, 2*radiusX, 2*radiusY);
+
+	std::vector<int> row(stamp->m_width);
+	for (int j=0; j<stamp->m_height; ++j)
+	{
+		float dy = float(j - radiusY)/radiusY;
+		for (int i=0; i<stamp->m_width; ++i)
+		{
+			float dx = float(i - radiusX)/radiusX;
+			float dist = sqrt(dx*dx + dy*dy);
+			if (dist < 1.0f)
+				row[i] = (int)((float)depth * (1.0f - dist));
+			else
+				row[i] = NO_HEIGHT;
+		}
+		stamp->_addRow(j, &row[0]);
+	}
+	return stamp;
+}
+
+DropStamp* DropStamp::CreateFromImage(const int* heights, int width, int height)
+{
+	DropStamp* stamp = new DropStamp(-width/2, -height/2, width, height);
+
+	std::vector<int> row(width);
+	for (int j=0; j<height; ++j)
+	{
+		for (int i=0; i<width; ++i)
+		{
+			int value = heights[j*width + i];
+			row[i] = value ? value : NO_HEIGHT;
+		}
+		stamp->_addRow(j, &row[0]);
+	}
+	return stamp;
+}
+
+void DropStamp::_addRow(int row, const int* heights)
+{
+	int i = 0;
+	while (i < m_width)
+	{
+		if (heights[i] == NO_HEIGHT)
+		{
+			++i;
+			continue;
+		}
+
+		Run run;
+		run.row = row;
+		run.column = i;
+		run.offset = int(m_values.size());
+		for (; i < m_width && heights[i] != NO_HEIGHT; ++i)
+		{
+			int value = std::min(std::max(heights[i], -MAX_DROP_HEIGHT), MAX_DROP_HEIGHT);
+			m_values.push_back(value);
+			m_values16.push_back(s16(value));
+		}
+		run.count = int(m_values.size()) - run.offset;
+		m_runs.push_back(run);
+	}
+}
+
+void DropStamp::Write(int* heights, int stride, int x, int y, int x0, int y0, int x1, int y1) const
+{
+	if (!m_runs.empty())
+		this->_write(heights, &m_values[0], stride, x, y, x0, y0, x1, y1);
+}
+
+void DropStamp::Write(s16* heights, int stride, int x, int y, int x0, int y0, int x1, int y1) const
+{
+	if (!m_runs.empty())
+		this->_write(heights, &m_values16[0], stride, x, y, x0, y0, x1, y1);
+}
+
+template<typename T>
+void DropStamp::_write(T* heights, const T* values, int stride, int x, int y, int x0, int y0, int x1, int y1) const
+{
+	for (size_t i=0; i<m_runs.size(); ++i)
+	{
+		const Run& run = m_runs[i];
+		int row = y + m_top + run.row;
+		if (row < y0 || row >= y1)
+			continue;
+
+		//clip the run, then it is a plain copy
+		int begin = x + m_left + run.column;
+		int end = begin + run.count;
+		int clippedBegin = std::max(begin, x0);
+		int clippedEnd = std::min(end, x1);
+		if (clippedBegin >= clippedEnd)
+			continue;
+
+		memcpy(heights + row*stride + clippedBegin, values + run.offset + (clippedBegin - begin),
+			sizeof(T)*(clippedEnd - clippedBegin));
+	}
+}
+
+DropStampCache::~DropStampCache()
+{
+	for (auto it = m_radialStamps.begin(); it != m_radialStamps.end(); ++it)
+		delete it->second;
+}
+
+const DropStamp* DropStampCache::GetRadial(int radius, int depth)
+{
+	u64 key = (u64(u32(radius)) << 32) | u32(depth);
+	auto it = m_radialStamps.find(key);
+	if (it != m_radialStamps.end())
+		return it->second;
+
+	DropStamp* stamp = DropStamp::CreateRadial(radius, depth);
+	m_radialStamps[key] = stamp;
+	return stamp;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <core/types.h>
+
+//! Precomputed heights a drop writes into the simulation, centred on the
+//! drop point.
+//!
+//! Heights are clamped to the range a drop may write and stored as runs of
+//! consecutive cells, so writing a stamp is one row copy per run instead of a
+//! distance and a divide per cell. Cells outside every run keep their height.
+class DropStamp
+{
+public:
+	//! depth falling off linearly to 0 at radius, the classic touch drop
+	static DropStamp* CreateRadial(int radius, int depth);
+
+	//! The same fall-off over an ellipse, e.g. a finger pressed flat.
+	static DropStamp* CreateEllipse(int radiusX, int radiusY, int depth);
+
+	//! width x height heights centred on the drop point, 0 cells are left out.
+	static DropStamp* CreateFromImage(const int* heights, int width, int height);
+
+	//! Writes the stamp centred at x, y, only inside [x0, x1) x [y0, y1).
+	void Write(int* heights, int stride, int x, int y, int x0, int y0, int x1, int y1) const;
+	void Write(s16* heights, int stride, int x, int y, int x0, int y0, int x1, int y1) const;
+
+	//! Box the stamp may touch, relative to the drop point. Cells inside it
+	//! need not all be written.
+	int GetLeft() const;
+	int GetTop() const;
+	int GetWidth() const;
+	int GetHeight() const;
+
+private:
+	DropStamp(int left, int top, int width, int height);
+
+	//! Adds a run for every stretch of written cells in a box row, heights
+	//! are clamped.
+	void _addRow(int row, const int* heights);
+
+	//! marks a cell inside the box the stamp leaves alone
+	static const int NO_HEIGHT = 0x7fffffff;
+
+	template<typename T>
+	void _write(T* heights, const T* values, int stride, int x, int y, int x0, int y0, int x1, int y1) const;
+
+	struct Run
+	{
+		int		row;
+		int		column;
+		int		count;
+		int		offset;
+	};
+
+	int					m_left;
+	int					m_top;
+	int					m_width;
+	int					m_height;
+
+	std::vector<Run>	m_runs;
+	std::vector<int>	m_values;
+	std::vector<s16>	m_values16;
+};
+
+//! Radial stamps by radius and depth, built on first use.
+class DropStampCache
+{
+public:
+	~DropStampCache();
+
+	const DropStamp* GetRadial(int radius, int depth);
+
+private:
+	std::unordered_map<u64, DropStamp*>	m_radialStamps;
+};
+
+inline int
+DropStamp::GetLeft() const
+{
+	return m_left;
+}
+
+inline int
+DropStamp::GetTop() const
+{
+	return m_top;
+}
+
+inline int
+DropStamp::GetWidth() const
+{
+	return m_width;
+}
+
+inline int
+DropStamp::GetHeight() const
+{
+	return m_height;
+}
@@ -0,0 +1,67 @@
+"																	\n\
+precision highp float;												\n\
+uniform sampler2D heights;											\n\
+uniform vec2 gridSize;												\n\
+uniform float damping;												\n\
+uniform vec3 drops[8];												\n\
+uniform int dropCount;												\n\
+																	\n\
+const float DROP_RADIUS = 12.0;										\n\
+																	\n\
+float truncate(float value)											\n\
+{																	\n\
+	return sign(value)*floor(abs(value));							\n\
+}																	\n\
+																	\n\
+float height(vec2 cell)												\n\
+{																	\n\
+	return texture2D(heights, (cell + 0.5)/gridSize).r;				\n\
+}																	\n\
+																	\n\
+void main()															\n\
+{																	\n\
+	//r is the height, g the height one step back					\n\
+	vec2 cell = floor(gl_FragCoord.xy);								\n\
+	if (any(lessThan(cell, vec2(2.0))) || any(greaterThanEqual(cell, gridSize - 2.0)))	\n\
+	{																\n\
+		gl_FragColor = vec4(0.0);									\n\
+		return;														\n\
+	}																\n\
+																	\n\
+	vec2 info = texture2D(heights, (cell + 0.5)/gridSize).rg;		\n\
+																	\n\
+	//drops replace the previous height, like the cpu solver		\n\
+	float previous = info.g;										\n\
+	for (int i=0; i<8; ++i)											\n\
+	{																\n\
+		if (i >= dropCount)											\n\
+			break;													\n\
+		vec2 d = cell - drops[i].xy;								\n\
+		float dist = dot(d, d);										\n\
+		if (dist < DROP_RADIUS*DROP_RADIUS)							\n\
+		{															\n\
+			float depth = truncate(drops[i].z*(DROP_RADIUS - sqrt(dist))/DROP_RADIUS);	\n\
+			previous = clamp(depth, -127.0, 127.0);					\n\
+		}															\n\
+	}																\n\
+																	\n\
+	float sum =														\n\
+		height(cell + vec2(-2.0, 0.0)) +							\n\
+		height(cell + vec2(2.0, 0.0)) +								\n\
+		height(cell + vec2(0.0, -2.0)) +							\n\
+		height(cell + vec2(0.0, 2.0)) +								\n\
+		height(cell + vec2(-1.0, 0.0)) +							\n\
+		height(cell + vec2(1.0, 0.0)) +								\n\
+		height(cell + vec2(0.0, -1.0)) +							\n\
+		height(cell + vec2(0.0, 1.0)) +								\n\
+		height(cell + vec2(-1.0, -1.0)) +							\n\
+		height(cell + vec2(1.0, -1.0)) +							\n\
+		height(cell + vec2(-1.0, 1.0)) +							\n\
+		height(cell + vec2(1.0, 1.0));								\n\
+																	\n\
+	float value = sum/6.0 - previous;								\n\
+	value -= value*damping;											\n\
+																	\n\
+	gl_FragColor = vec4(truncate(value), info.r, 0.0, 1.0);			\n\
+}																	\n\
+";
@@ -1,20 +1,20 @@
-"												\n\
-precision lowp float;							\n\
-uniform sampler2D water;						\n\
-uniform vec3 light;								\n\
-uniform vec3 eye;								\n\
-												\n\
-varying vec3 vPosition;							\n\
-varying vec2 vCoord;							\n\
-												\n\
-float two2one(vec2 value)						\n\
-{                                               \n\
-	return dot(value, vec2(1.0, 1.0/255.0));    \n\
-}												\n\
-void main()										\n\
-{                                               \n\
-	vec4 info = texture2D(water, vCoord);		\n\
-	float value = two2one(info.rg);				\n\
-	gl_FragColor = vec4(value, 0.0, 0.0, 1.0);						\n\
-}												\n\
+"#version 300 es																			\n\
+precision lowp float;																		\n\
+uniform sampler2D water;																	\n\
+uniform vec3 eye;																			\n\
+																							\n\
+in vec3 vPosition;																			\n\
+in vec2 vCoord;																				\n\
+layout(location = 0) out vec4 outColor;														\n\
+																							\n\
+float two2one(vec2 value)																	\n\
+{																							\n\
+	return dot(value, vec2(1.0, 1.0/255.0));												\n\
+}																							\n\
+void main()																					\n\
+{																							\n\
+	vec4 info = texture(water, vCoord);														\n\
+	float value = two2one(info.rg);															\n\
+	outColor = vec4(value, 0.0, 0.0, 1.0);													\n\
+}																							\n\
 ";
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "GpuProfiler.h"
+#include "esutils.h"
+#include <core/Clock.h>
+
+//GL_EXT_disjoint_timer_query, not in every gl2ext.h this builds against
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT					0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT					0x8FBB
+#endif
+#ifndef GL_QUERY_RESULT_EXT
+#define GL_QUERY_RESULT_EXT					0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE_EXT
+#define GL_QUERY_RESULT_AVAILABLE_EXT		0x8867
+#endif
+
+typedef void (GL_APIENTRYP PFNGPUPROFILERGENQUERIES) (GLsizei n, GLuint* ids);
+typedef void (GL_APIENTRYP PFNGPUPROFILERDELETEQUERIES) (GLsizei n, const GLuint* ids);
+typedef void (GL_APIENTRYP PFNGPUPROFILERBEGINQUERY) (GLenum target, GLuint id);
+typedef void (GL_APIENTRYP PFNGPUPROFILERENDQUERY) (GLenum target);
+typedef void (GL_APIENTRYP PFNGPUPROFILERGETQUERYOBJECTUIV) (GLuint id, GLenum pname, GLuint* params);
+typedef void (GL_APIENTRYP PFNGPUPROFILERGETQUERYOBJECTUI64V) (GLuint id, GLenum pname, GLuint64* params);
+
+static PFNGPUPROFILERGENQUERIES				s_glGenQueriesEXT = nullptr;
+static PFNGPUPROFILERDELETEQUERIES			s_glDeleteQueriesEXT = nullptr;
+static PFNGPUPROFILERBEGINQUERY				s_glBeginQueryEXT = nullptr;
+static PFNGPUPROFILERENDQUERY				s_glEndQueryEXT = nullptr;
+static PFNGPUPROFILERGETQUERYOBJECTUIV		s_glGetQueryObjectuivEXT = nullptr;
+static PFNGPUPROFILERGETQUERYOBJECTUI64V	s_glGetQueryObjectui64vEXT = nullptr;
+
+bool GpuProfiler::IsSupported()
+{
+	if (!esHasExtension("GL_EXT_disjoint_timer_query"))
+		return false;
+
+	s_glGenQueriesEXT = (PFNGPUPROFILERGENQUERIES)eglGetProcAddress("glGenQueriesEXT");
+	s_glDeleteQueriesEXT = (PFNGPUPROFILERDELETEQUERIES)eglGetProcAddress("glDeleteQueriesEXT");
+	s_glBeginQueryEXT = (PFNGPUPROFILERBEGINQUERY)eglGetProcAddress("glBeginQueryEXT");
+	s_glEndQueryEXT = (PFNGPUPROFILERENDQUERY)eglGetProcAddress("glEndQueryEXT");
+	s_glGetQueryObjectuivEXT = (PFNGPUPROFILERGETQUERYOBJECTUIV)eglGetProcAddress("glGetQueryObjectuivEXT");
+	s_glGetQueryObjectui64vEXT = (PFNGPUPROFILERGETQUERYOBJECTUI64V)eglGetProcAddress("glGetQueryObjectui64vEXT");
+
+	return s_glGenQueriesEXT && s_glDeleteQueriesEXT && s_glBeginQueryEXT && s_glEndQueryEXT
+		&& s_glGetQueryObjectuivEXT && s_glGetQueryObjectui64vEXT;
+}
+
+GpuProfiler::GpuProfiler():m_first(0)
+	,m_count(0)
+	,m_depth(0)
+	,m_active(false)
+{
+	s_glGenQueriesEXT(MAX_PENDING_QUERIES, m_queries);
+
+	//clear the flag left over from before the first query
+	GLint disjoint = 0;
+	glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	s_glDeleteQueriesEXT(MAX_PENDING_QUERIES, m_queries);
+}
+
+void GpuProfiler::Begin(const char* name)
+{
+	if (m_depth++ > 0)
+		return;
+
+	//all queries still in flight, skip this one rather than wait
+	m_active = (m_count < MAX_PENDING_QUERIES);
+	if (!m_active)
+		return;
+
+	int index = (m_first + m_count)%MAX_PENDING_QUERIES;
+	m_pending[index].name = name;
+	m_pending[index].begin = getTimeMicroseconds();
+	s_glBeginQueryEXT(GL_TIME_ELAPSED_EXT, m_queries[index]);
+}
+
+void GpuProfiler::End()
+{
+	if (--m_depth > 0 || !m_active)
+		return;
+
+	s_glEndQueryEXT(GL_TIME_ELAPSED_EXT);
+	++m_count;
+	m_active = false;
+}
+
+void GpuProfiler::Collect()
+{
+	//a disjoint event invalidates everything measured since the last check
+	GLint disjoint = 0;
+	glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+	Profiler* profiler = Profiler::instance();
+	while (m_count > 0)
+	{
+		GLuint query = m_queries[m_first];
+
+		//results arrive in order, stop at the first one still running
+		GLuint available = 0;
+		s_glGetQueryObjectuivEXT(query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+		if (!available)
+			break;
+
+		GLuint64 elapsed = 0;
+		s_glGetQueryObjectui64vEXT(query, GL_QUERY_RESULT_EXT, &elapsed);
+
+		const PendingQuery& pending = m_pending[m_first];
+		if (profiler && !disjoint)
+			profiler->record(pending.name, pending.begin, pending.begin + elapsed/1000, Profiler::GPU_TRACK);
+
+		m_first = (m_first + 1)%MAX_PENDING_QUERIES;
+		--m_count;
+	}
+}
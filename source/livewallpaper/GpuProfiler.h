@@ -0,0 +1,78 @@
+#pragma once
+#include <GLES3/gl3.h>
+#include <core/types.h>
+#include <core/singleton.h>
+#include <core/Profiler.h>
+
+//! GPU stage timings through GL_EXT_disjoint_timer_query.
+//!
+//! Each Begin()/End() pair wraps one time elapsed query. Results are picked up
+//! a few frames later by Collect() without stalling the pipeline and go into
+//! the Profiler ring on its GPU track, placed at the cpu time the commands were
+//! issued. Queries cannot nest, an inner Begin() is ignored.
+//!
+//! Results from intervals the driver flags as disjoint are dropped.
+class GpuProfiler:public Singleton<GpuProfiler>
+{
+	friend class Singleton<GpuProfiler>;
+
+public:
+	//! Needs a current context.
+	static bool IsSupported();
+
+	void Begin(const char* name);
+	void End();
+
+	//! Call once per frame, forwards every finished query to the Profiler.
+	void Collect();
+
+protected:
+	GpuProfiler();
+	~GpuProfiler();
+
+private:
+	enum
+	{
+		MAX_PENDING_QUERIES = 64,
+	};
+
+	struct PendingQuery
+	{
+		const char*	name;
+		u64			begin;
+	};
+
+	GLuint			m_queries[MAX_PENDING_QUERIES];
+	PendingQuery	m_pending[MAX_PENDING_QUERIES];
+
+	//ring of issued queries, m_first is the oldest
+	int				m_first;
+	int				m_count;
+
+	//nesting depth, and whether the outermost scope got a query
+	int				m_depth;
+	bool			m_active;
+};
+
+//! Times the GPU work issued in the enclosing block.
+class GpuProfileScope
+{
+public:
+	explicit GpuProfileScope(const char* name)
+		:m_profiler(GpuProfiler::instance())
+	{
+		if (m_profiler)
+			m_profiler->Begin(name);
+	}
+
+	~GpuProfileScope()
+	{
+		if (m_profiler)
+			m_profiler->End();
+	}
+
+private:
+	GpuProfiler*	m_profiler;
+};
+
+#define GPU_PROFILE_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
@@ -0,0 +1,141 @@
+#include "GpuRippleSimulation.h"
+#include "RippleKernel.h"
+#include "framebuffer.h"
+#include "shader.h"
+#include "esutils.h"
+#include <core/string_hash.h>
+#include <algorithm>
+
+using namespace jenny;
+
+//must match the drops array in FragmentShader_Ripple_Step.h
+static const int GPU_RIPPLE_MAX_DROPS = 8;
+
+//the cpu solver needs about 120 steps to flatten one drop and 380 to flatten
+//a field saturated by rain, the gpu one truncates the same way
+static const int GPU_RIPPLE_REST_STEPS = 512;
+
+GpuRippleSimulation::GpuRippleSimulation(int width, int height):m_width(width)
+	,m_height(height)
+	,m_fbRead(nullptr)
+	,m_fbWrite(nullptr)
+	,m_shader_step(nullptr)
+	,m_quadVertexBuffer(0)
+	,m_restingSteps(GPU_RIPPLE_REST_STEPS)
+	,m_fullPrecision(esHasExtension("GL_EXT_color_buffer_float") != GL_FALSE)
+{
+	unsigned int format = m_fullPrecision ? EFBT_TEXTURE_RG32F : EFBT_TEXTURE_RG16F;
+	m_fbRead = new FrameBuffer(m_width, m_height, format);
+	m_fbWrite = new FrameBuffer(m_width, m_height, format);
+
+	//flat water
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	m_fbRead->Begin();
+	glClear(GL_COLOR_BUFFER_BIT);
+	m_fbWrite->Begin();
+	glClear(GL_COLOR_BUFFER_BIT);
+	m_fbWrite->End();
+
+	const char* strVertexShader =
+	#include "VertexShader_Common.h"
+	const char* strFragmentShader =
+	#include "FragmentShader_Ripple_Step.h"
+	m_shader_step = new Shader(strVertexShader, strFragmentShader);
+
+	//one triangle strip over the whole target
+	const GLfloat quadVertexBuffer[] =
+	{
+		-1.0f, -1.0f,
+		1.0f, -1.0f,
+		-1.0f, 1.0f,
+		1.0f, 1.0f
+	};
+	glGenBuffers(1, &m_quadVertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_quadVertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertexBuffer), quadVertexBuffer, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GpuRippleSimulation::~GpuRippleSimulation()
+{
+	glDeleteBuffers(1, &m_quadVertexBuffer);
+	delete m_shader_step;
+	delete m_fbWrite;
+	delete m_fbRead;
+}
+
+bool GpuRippleSimulation::IsSupported()
+{
+	if (esGetContextMajorVersion() < 3)
+		return false;
+
+	if (!esHasExtension("GL_EXT_color_buffer_float") && !esHasExtension("GL_EXT_color_buffer_half_float"))
+		return false;
+
+	GLint vertexTextureUnits = 0;
+	glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &vertexTextureUnits);
+	return vertexTextureUnits > 0;
+}
+
+GLuint GpuRippleSimulation::GetHeightTexture() const
+{
+	return m_fbRead->GetColorTexture();
+}
+
+bool GpuRippleSimulation::IsAtRest() const
+{
+	return m_pendingDrops.empty() && m_restingSteps >= GPU_RIPPLE_REST_STEPS;
+}
+
+void GpuRippleSimulation::Drop(int x, int y, int depth)
+{
+	m_pendingDrops.push_back(vector3df((float)x, (float)y, (float)depth));
+}
+
+void GpuRippleSimulation::Step()
+{
+	//drops beyond what one step takes wait for the next one
+	int dropCount = std::min((int)m_pendingDrops.size(), GPU_RIPPLE_MAX_DROPS);
+
+	glViewport(0, 0, m_width, m_height);
+	m_fbWrite->Begin();
+	m_shader_step->bind();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_fbRead->GetColorTexture());
+	m_shader_step->uniform(SHADER_UNIFORM("heights"), 0);
+	m_shader_step->uniform(SHADER_UNIFORM("gridSize"), vector2df((float)m_width, (float)m_height));
+	m_shader_step->uniform(SHADER_UNIFORM("damping"), RIPPLE_DAMPING_FACTOR);
+	m_shader_step->uniform(SHADER_UNIFORM("dropCount"), dropCount);
+	if (dropCount > 0)
+		m_shader_step->uniform(SHADER_UNIFORM("drops[0]"), &m_pendingDrops[0], dropCount);
+	this->_drawQuad();
+	m_shader_step->unbind();
+	m_fbWrite->End();
+
+	m_fbWrite->Swap(m_fbRead);
+	m_pendingDrops.erase(m_pendingDrops.begin(), m_pendingDrops.begin() + dropCount);
+	m_restingSteps = (dropCount > 0) ? 0 : std::min(m_restingSteps + 1, GPU_RIPPLE_REST_STEPS);
+}
+
+void GpuRippleSimulation::_drawQuad()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, m_quadVertexBuffer);
+
+	Shader::VertexAttributeIter iter = m_shader_step->getVertexAttributesBegin();
+	for (; iter != m_shader_step->getVertexAttributesEnd(); ++iter)
+	{
+		if (iter->attributeType == E_Vertex_Attribute::EVA_POSITION)
+		{
+			glEnableVertexAttribArray(iter->location);
+			glVertexAttribPointer(iter->location, 2, GL_FLOAT, 0, sizeof(GLfloat)*2, NULL);
+		}
+	}
+
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	for (iter = m_shader_step->getVertexAttributesBegin(); iter != m_shader_step->getVertexAttributesEnd(); ++iter)
+	{
+		glDisableVertexAttribArray(iter->location);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
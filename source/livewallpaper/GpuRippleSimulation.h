@@ -0,0 +1,88 @@
+#pragma once
+#include <vector>
+#include <GLES3/gl3.h>
+#include <math/vector3d.h>
+
+class FrameBuffer;
+class Shader;
+
+//! Height field solver that runs entirely on the GPU.
+//!
+//! Heights live in a pair of float render targets that are ping-ponged every
+//! step, red holds the current height and green the previous one, in the same
+//! units as RippleSimulation. Queued drops travel as uniforms of the next step,
+//! so nothing but a handful of floats crosses to the GPU. The mesh samples
+//! GetHeightTexture() in its vertex shader.
+//!
+//! The targets are 32 bit floats when the context can render to them. Half
+//! floats, the fallback, only hold integers up to +-2048 exactly while rain
+//! drives the heights past 30000, so from the first large wave on they are
+//! rounded and the field drifts away from the CPU solver's. Even at 32 bit
+//! the two solvers only look alike, they are not bit-identical: GLSL division
+//! need not round like the CPU's and the GPU does not saturate like
+//! ERP_INT16 heights.
+class GpuRippleSimulation
+{
+public:
+	GpuRippleSimulation(int width, int height);
+	~GpuRippleSimulation();
+
+	//! Needs a current context that can render to half float targets and
+	//! fetch textures in vertex shaders.
+	static bool IsSupported();
+
+	//! Renders one step, changes the framebuffer binding and viewport.
+	void Step();
+
+	//! Applied on the next Step().
+	void Drop(int x, int y, int depth);
+
+	//! No drop is queued and the last one is long enough ago that even waves
+	//! saturated by rain have died out. Reading the heights back would stall
+	//! the pipeline, so this is an upper bound rather than a check.
+	bool IsAtRest() const;
+
+	int GetWidth() const;
+	int GetHeight() const;
+
+	//! 32 bit float heights, false on the half float fallback.
+	bool IsFullPrecision() const;
+
+	GLuint GetHeightTexture() const;
+
+private:
+	void _drawQuad();
+
+private:
+	int							m_width;
+	int							m_height;
+
+	FrameBuffer*				m_fbRead;
+	FrameBuffer*				m_fbWrite;
+	Shader*						m_shader_step;
+	GLuint						m_quadVertexBuffer;
+
+	std::vector<jenny::vector3df>	m_pendingDrops;
+
+	//steps since the last drop, counts up to the rest steps only
+	int							m_restingSteps;
+	bool						m_fullPrecision;
+};
+
+inline int
+GpuRippleSimulation::GetWidth() const
+{
+	return m_width;
+}
+
+inline int
+GpuRippleSimulation::GetHeight() const
+{
+	return m_height;
+}
+
+inline bool
+GpuRippleSimulation::IsFullPrecision() const
+{
+	return m_fullPrecision;
+}
@@ -0,0 +1,290 @@
+#include "GridMesh.h"
+#include "esutils.h"
+#include <algorithm>
+
+//a 16 bit index reaches this many vertices, one less with strips since
+//0xffff is the restart index
+static const u32 MAX_SHORT_INDEX_VERTICES = 65536;
+
+//rows of level 0 the ACMR is measured over, enough to reach the steady state
+static const int ACMR_ROWS = 64;
+
+const char* getGridIndexOrderName(E_Grid_Index_Order order)
+{
+	switch (order)
+	{
+	case EGIO_ROW_MAJOR:
+		return "row-major";
+	case EGIO_STRIPED:
+		return "striped";
+	case EGIO_Z_ORDER:
+		return "z-order";
+	default:
+		return "unknown";
+	}
+}
+
+//every step-th vertex in [begin, end) plus both ends, on multiples of step
+//so neighbouring bands agree on their shared row
+static void buildLattice(std::vector<int>& samples, int begin, int end, int step)
+{
+	samples.clear();
+	samples.push_back(begin);
+	for (int i=(begin/step + 1)*step; i<end-1; i+=step)
+		samples.push_back(i);
+	if (end-1 > begin)
+		samples.push_back(end-1);
+}
+
+//interleaves the bits of x and y, x in the even bits
+static u32 getMortonCode(u32 x, u32 y)
+{
+	u32 code = 0;
+	for (int bit=0; bit<16; ++bit)
+	{
+		code |= ((x >> bit) & 1) << (2*bit);
+		code |= ((y >> bit) & 1) << (2*bit + 1);
+	}
+	return code;
+}
+
+GridMesh::GridMesh(int width, int height, const GridMeshSettings& settings):m_width(width)
+	,m_height(height)
+	,m_settings(settings)
+	,m_levelCount(1)
+	,m_indexType(GL_UNSIGNED_SHORT)
+	,m_acmr(0.0f)
+	,m_rowMajorAcmr(0.0f)
+{
+	//fixed index primitive restart is core in es3 and has no es2 extension
+	if (m_settings.strips && esGetContextMajorVersion() < 3)
+	{
+		esLogMessage("primitive restart not supported, using triangle lists\n");
+		m_settings.strips = false;
+	}
+
+	//stop before the coarsest lattice gets below a handful of quads across
+	int minSize = std::min(width, height);
+	while (m_levelCount < m_settings.levelCount && (minSize >> m_levelCount) >= 4)
+		++m_levelCount;
+
+	int rows = std::min(height, ACMR_ROWS);
+	std::vector<u32> indices;
+	this->BuildIndices(indices, 0, 0, rows);
+	m_acmr = ComputeACMR(indices, m_settings.strips, m_settings.cacheSize);
+
+	std::vector<int> columnSamples, rowSamples;
+	buildLattice(columnSamples, 0, width, 1);
+	buildLattice(rowSamples, 0, rows, 1);
+	indices.clear();
+	this->_buildQuadList(indices, EGIO_ROW_MAJOR, columnSamples, rowSamples, 0);
+	m_rowMajorAcmr = ComputeACMR(indices, false, m_settings.cacheSize);
+}
+
+MeshObject* GridMesh::CreateMesh(GLuint vbo)
+{
+	bool uintIndices = m_settings.uintIndices
+		&& (esGetContextMajorVersion() >= 3 || esHasExtension("GL_OES_element_index_uint"));
+
+	u32 shortLimit = m_settings.strips ? MAX_SHORT_INDEX_VERTICES - 1 : MAX_SHORT_INDEX_VERTICES;
+	int bandRows = m_height;
+	m_indexType = GL_UNSIGNED_SHORT;
+	if (u32(m_width*m_height) > shortLimit)
+	{
+		if (uintIndices)
+			m_indexType = GL_UNSIGNED_INT;
+		else
+			bandRows = shortLimit/m_width;
+	}
+
+	//neighbouring bands share their edge row, each band is a chunk drawn from
+	//its own base vertex so its indices stay below the 16 bit limit
+	std::vector<u32> indices;
+	std::vector<u32> bandIndices;
+	m_levels.assign(m_levelCount, std::vector<MeshChunk>());
+	for (int level=0; level<m_levelCount; ++level)
+	{
+		for (int rowBegin=0; rowBegin<m_height-1; rowBegin+=bandRows-1)
+		{
+			int rowEnd = std::min(rowBegin + bandRows, m_height);
+			this->BuildIndices(bandIndices, level, rowBegin, rowEnd);
+
+			MeshChunk chunk = {u32(rowBegin*m_width), u32(indices.size()), u32(bandIndices.size())};
+			m_levels[level].push_back(chunk);
+			indices.insert(indices.end(), bandIndices.begin(), bandIndices.end());
+		}
+	}
+
+	GLuint ibo = 0;
+	glGenBuffers(1, &ibo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	if (m_indexType == GL_UNSIGNED_INT)
+	{
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*indices.size(), &indices[0], GL_STATIC_DRAW);
+	}
+	else
+	{
+		//the restart index narrows to 0xffff
+		std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort)*shortIndices.size(), &shortIndices[0], GL_STATIC_DRAW);
+	}
+
+	MeshObject* mesh = new MeshObject(vbo, ibo);
+	mesh->setIndexType(m_indexType);
+	mesh->setPrimitiveType(m_settings.strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
+	this->SetLevel(mesh, 0);
+	return mesh;
+}
+
+void GridMesh::SetLevel(MeshObject* mesh, int level) const
+{
+	level = std::min(std::max(level, 0), m_levelCount - 1);
+
+	u32 indexCount = 0;
+	mesh->clearChunks();
+	for (size_t i=0; i<m_levels[level].size(); ++i)
+	{
+		const MeshChunk& chunk = m_levels[level][i];
+		mesh->addChunk(chunk.m_baseVertex, chunk.m_firstIndex, chunk.m_indexCount);
+		indexCount += chunk.m_indexCount;
+	}
+	mesh->setIndexCount(indexCount);
+}
+
+void GridMesh::BuildIndices(std::vector<u32>& indices, int level, int rowBegin, int rowEnd) const
+{
+	std::vector<int> columns, rows;
+	buildLattice(columns, 0, m_width, 1 << level);
+	buildLattice(rows, rowBegin, rowEnd, 1 << level);
+
+	indices.clear();
+	if (m_settings.strips)
+	{
+		int stripeWidth = (m_settings.order == EGIO_ROW_MAJOR) ? int(columns.size()) : this->_getStripeWidth();
+		this->_buildStrips(indices, stripeWidth, columns, rows, rowBegin);
+	}
+	else
+	{
+		this->_buildQuadList(indices, m_settings.order, columns, rows, rowBegin);
+	}
+}
+
+void GridMesh::_buildQuadList(std::vector<u32>& indices, E_Grid_Index_Order order,
+	const std::vector<int>& columns, const std::vector<int>& rows, int rowBegin) const
+{
+	int quadColumns = int(columns.size()) - 1;
+	int quadRows = int(rows.size()) - 1;
+
+	//quads as (column, row) pairs in draw order
+	std::vector<std::pair<int, int> > quads;
+	quads.reserve(quadColumns*quadRows);
+	if (order == EGIO_STRIPED)
+	{
+		int stripeWidth = this->_getStripeWidth();
+		for (int stripe=0; stripe<quadColumns; stripe+=stripeWidth)
+		{
+			int stripeEnd = std::min(stripe + stripeWidth, quadColumns);
+			for (int y=0; y<quadRows; ++y)
+				for (int x=stripe; x<stripeEnd; ++x)
+					quads.push_back(std::make_pair(x, y));
+		}
+	}
+	else if (order == EGIO_Z_ORDER)
+	{
+		std::vector<std::pair<u32, int> > codes(quadColumns*quadRows);
+		for (int y=0; y<quadRows; ++y)
+			for (int x=0; x<quadColumns; ++x)
+				codes[y*quadColumns + x] = std::make_pair(getMortonCode(x, y), y*quadColumns + x);
+		std::sort(codes.begin(), codes.end());
+
+		for (size_t i=0; i<codes.size(); ++i)
+			quads.push_back(std::make_pair(codes[i].second%quadColumns, codes[i].second/quadColumns));
+	}
+	else
+	{
+		for (int y=0; y<quadRows; ++y)
+			for (int x=0; x<quadColumns; ++x)
+				quads.push_back(std::make_pair(x, y));
+	}
+
+	indices.reserve(indices.size() + quads.size()*6);
+	for (size_t i=0; i<quads.size(); ++i)
+	{
+		int x = quads[i].first;
+		int y = quads[i].second;
+		u32 top = u32((rows[y] - rowBegin)*m_width);
+		u32 bottom = u32((rows[y + 1] - rowBegin)*m_width);
+
+		indices.push_back(top + columns[x]);
+		indices.push_back(top + columns[x + 1]);
+		indices.push_back(bottom + columns[x]);
+
+		indices.push_back(bottom + columns[x]);
+		indices.push_back(top + columns[x + 1]);
+		indices.push_back(bottom + columns[x + 1]);
+	}
+}
+
+void GridMesh::_buildStrips(std::vector<u32>& indices, int stripeWidth,
+	const std::vector<int>& columns, const std::vector<int>& rows, int rowBegin) const
+{
+	//one strip per row of each stripe, alternating top and bottom vertices
+	//gives the same triangles as the quad list with the opposite winding
+	int quadColumns = int(columns.size()) - 1;
+	int quadRows = int(rows.size()) - 1;
+	for (int stripe=0; stripe<quadColumns; stripe+=stripeWidth)
+	{
+		int stripeEnd = std::min(stripe + stripeWidth, quadColumns);
+		for (int y=0; y<quadRows; ++y)
+		{
+			if (!indices.empty())
+				indices.push_back(RESTART_INDEX);
+
+			u32 top = u32((rows[y] - rowBegin)*m_width);
+			u32 bottom = u32((rows[y + 1] - rowBegin)*m_width);
+			for (int x=stripe; x<=stripeEnd; ++x)
+			{
+				indices.push_back(top + columns[x]);
+				indices.push_back(bottom + columns[x]);
+			}
+		}
+	}
+}
+
+int GridMesh::_getStripeWidth() const
+{
+	//two rows of stripeWidth + 1 vertices have to fit the cache together
+	return std::max(m_settings.cacheSize/2 - 1, 1);
+}
+
+float GridMesh::ComputeACMR(const std::vector<u32>& indices, bool strips, int cacheSize)
+{
+	std::vector<u32> cache(std::max(cacheSize, 1), RESTART_INDEX);
+	size_t next = 0;
+
+	u32 misses = 0;
+	u32 triangles = 0;
+	int stripLength = 0;
+	for (size_t i=0; i<indices.size(); ++i)
+	{
+		u32 index = indices[i];
+		if (index == RESTART_INDEX)
+		{
+			stripLength = 0;
+			continue;
+		}
+
+		if (std::find(cache.begin(), cache.end(), index) == cache.end())
+		{
+			cache[next] = index;
+			next = (next + 1)%cache.size();
+			++misses;
+		}
+
+		if (!strips)
+			triangles += (i%3 == 2) ? 1 : 0;
+		else if (++stripLength >= 3)
+			++triangles;
+	}
+	return triangles ? float(misses)/triangles : 0.0f;
+}
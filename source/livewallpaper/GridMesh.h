@@ -0,0 +1,141 @@
+#pragma once
+#include <GLES3/gl3.h>
+#include <vector>
+#include <core/types.h>
+#include "Mesh.h"
+
+//! Order the quads of a grid are emitted in.
+enum E_Grid_Index_Order
+{
+	EGIO_ROW_MAJOR = 0,
+	//! Vertical stripes narrow enough that the row above stays in the
+	//! post-transform cache while the next row is drawn.
+	EGIO_STRIPED,
+	//! Quads sorted along a Morton curve, independent of the cache size.
+	EGIO_Z_ORDER,
+
+	EGIO_COUNT,
+};
+
+const char* getGridIndexOrderName(E_Grid_Index_Order order);
+
+struct GridMeshSettings
+{
+	GridMeshSettings():order(EGIO_STRIPED)
+					,strips(false)
+					,levelCount(4)
+					,cacheSize(24)
+					,uintIndices(true)
+	{
+	}
+
+	E_Grid_Index_Order	order;
+
+	//triangle strips joined by primitive restart, es3 only, strips always
+	//follow the stripes so EGIO_Z_ORDER draws them like EGIO_STRIPED
+	bool	strips;
+
+	//lod levels, each one halves the grid resolution of the one before
+	int		levelCount;
+
+	//post-transform cache entries the stripe width is sized for
+	int		cacheSize;
+
+	//false draws grids over 65536 vertices as 16 bit chunks even when the
+	//device takes 32 bit indices
+	bool	uintIndices;
+};
+
+//! Index buffers for a width x height grid of vertices, row-major in the
+//! vertex buffer.
+//!
+//! Every lod level is a coarser lattice over the same vertices, taking every
+//! 2^level-th row and column plus the last ones, so all levels share one
+//! vertex buffer and one index buffer. Grids too large for 16 bit indices
+//! use 32 bit ones where available, otherwise each level is split into row
+//! bands drawn as MeshChunks.
+class GridMesh
+{
+public:
+	GridMesh(int width, int height, const GridMeshSettings& settings);
+
+	//! Uploads the indices of every level into a new index buffer and returns
+	//! a mesh over vbo and that buffer drawing level 0. The mesh owns both.
+	MeshObject*	CreateMesh(GLuint vbo);
+
+	//! Points mesh, made by CreateMesh(), at the chunks of another level.
+	void		SetLevel(MeshObject* mesh, int level) const;
+
+	int			GetLevelCount() const;
+	int			GetWidth() const;
+	int			GetHeight() const;
+	const GridMeshSettings& GetSettings() const;
+
+	//! Average cache miss ratio, transformed vertices per triangle for a FIFO
+	//! post-transform cache of settings.cacheSize entries, measured over the
+	//! first rows of level 0 for the chosen order and for plain row-major.
+	float		GetACMR() const;
+	float		GetRowMajorACMR() const;
+
+	//! Indices of one level over vertex rows [rowBegin, rowEnd), relative to
+	//! the first vertex of rowBegin. Strips are separated by RESTART_INDEX.
+	void		BuildIndices(std::vector<u32>& indices, int level, int rowBegin, int rowEnd) const;
+
+	static float ComputeACMR(const std::vector<u32>& indices, bool strips, int cacheSize);
+
+	static const u32 RESTART_INDEX = 0xffffffff;
+
+private:
+	void		_buildQuadList(std::vector<u32>& indices, E_Grid_Index_Order order,
+					const std::vector<int>& columns, const std::vector<int>& rows, int rowBegin) const;
+	void		_buildStrips(std::vector<u32>& indices, int stripeWidth,
+					const std::vector<int>& columns, const std::vector<int>& rows, int rowBegin) const;
+	int			_getStripeWidth() const;
+
+	int					m_width;
+	int					m_height;
+	GridMeshSettings	m_settings;
+	int					m_levelCount;
+
+	GLenum				m_indexType;
+	std::vector<std::vector<MeshChunk> >	m_levels;
+
+	float				m_acmr;
+	float				m_rowMajorAcmr;
+};
+
+inline int
+GridMesh::GetLevelCount() const
+{
+	return m_levelCount;
+}
+
+inline int
+GridMesh::GetWidth() const
+{
+	return m_width;
+}
+
+inline int
+GridMesh::GetHeight() const
+{
+	return m_height;
+}
+
+inline const GridMeshSettings&
+GridMesh::GetSettings() const
+{
+	return m_settings;
+}
+
+inline float
+GridMesh::GetACMR() const
+{
+	return m_acmr;
+}
+
+inline float
+GridMesh::GetRowMajorACMR() const
+{
+	return m_rowMajorAcmr;
+}
@@ -1,17 +1,53 @@
 #include "Mesh.h"
+#include "shader.h"
+#include "esutils.h"
+#include <string.h>
 
-MeshObject::MeshObject(GLuint vbo, GLuint ibo):m_VBO(vbo)
+u32 getIndexTypeSize(GLenum indexType)
+{
+    switch (indexType)
+    {
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    case GL_UNSIGNED_INT:
+        return 4;
+    default:
+        return 2;
+    }
+}
+
+MeshObject::MeshObject(GLuint vbo, GLuint ibo):m_attributeMask(0)
+                                              ,m_layoutKey(0)
+                                              ,m_VBO(vbo)
                                               ,m_IBO(ibo)
                                               ,m_indexCount(0)
+                                              ,m_indexType(GL_UNSIGNED_SHORT)
+                                              ,m_primitiveType(GL_TRIANGLES)
 {
+    memset(m_attributes, 0, sizeof(m_attributes));
+    this->_updateLayoutKey();
 }
 
-MeshObject::MeshObject():m_VBO(0),m_IBO(0)
+MeshObject::MeshObject():m_attributeMask(0),m_layoutKey(0),m_VBO(0),m_IBO(0),m_indexCount(0),m_indexType(GL_UNSIGNED_SHORT),m_primitiveType(GL_TRIANGLES)
 {
+    memset(m_attributes, 0, sizeof(m_attributes));
+    this->_updateLayoutKey();
+}
+
+void MeshObject::addChunk(u32 baseVertex, u32 firstIndex, u32 indexCount)
+{
+    MeshChunk chunk;
+    chunk.m_baseVertex = baseVertex;
+    chunk.m_firstIndex = firstIndex;
+    chunk.m_indexCount = indexCount;
+    m_chunks.push_back(chunk);
 }
 
 MeshObject::~MeshObject()
 {
+    for (size_t i=0; i<m_vertexArrays.size(); ++i)
+        glDeleteVertexArrays(1, &m_vertexArrays[i].m_vertexArray);
+
     glDeleteBuffers(1,&m_VBO);
     glDeleteBuffers(1,&m_IBO);
 }
@@ -20,25 +56,165 @@ void MeshObject::addMeshAttribute(const char* attributeName,
                                   GLint elementNum, 
                                   GLenum elementType, 
                                   GLsizei stride, 
-                                  u32 offset)
+                                  u32 offset,
+                                  GLboolean normalized)
 {
     E_Vertex_Attribute attributeType = getShaderVertexAttribute(attributeName);
+    if (attributeType == E_Vertex_Attribute::EVA_UNKNOWN)
+        return;
 
-    MeshAttributeDef attributeDef;
+    MeshAttributeDef& attributeDef = m_attributes[static_cast<int>(attributeType)];
     attributeDef.m_elementNum = elementNum;
     attributeDef.m_elementType = elementType;
     attributeDef.m_stride = stride;
     attributeDef.m_offset = offset;
+    attributeDef.m_normalized = normalized;
+    attributeDef.m_buffer = 0;
 
-    m_attributeMap.insert(std::pair<E_Vertex_Attribute, MeshAttributeDef>(attributeType,attributeDef));
+    m_attributeMask |= 1u << static_cast<int>(attributeType);
+    this->_updateLayoutKey();
 }
 
 const MeshAttributeDef* MeshObject::getMeshAttribute(E_Vertex_Attribute attribute) const
 {
-    AttributeMap::const_iterator it = m_attributeMap.find(attribute);
-    if (it == m_attributeMap.end())
+    int index = static_cast<int>(attribute);
+    if (index >= static_cast<int>(E_Vertex_Attribute::EVA_COUNT) || !(m_attributeMask & (1u << index)))
     {
         return nullptr;
     }
-    return &it->second;
-}
\ No newline at end of file
+    return &m_attributes[index];
+}
+
+void MeshObject::setMeshAttributeSource(E_Vertex_Attribute attribute, GLuint buffer, u32 offset)
+{
+    MeshAttributeDef& attributeDef = m_attributes[static_cast<int>(attribute)];
+    if (attributeDef.m_buffer == buffer && attributeDef.m_offset == offset)
+        return;
+
+    attributeDef.m_buffer = buffer;
+    attributeDef.m_offset = offset;
+    this->_updateLayoutKey();
+}
+
+void MeshObject::_updateLayoutKey()
+{
+    //FNV-1a over the buffers and the attributes added
+    u64 key = 14695981039346656037ULL;
+    const u8* data = reinterpret_cast<const u8*>(m_attributes);
+    for (size_t i=0; i<sizeof(m_attributes); ++i)
+        key = (key ^ data[i])*1099511628211ULL;
+
+    u32 values[3] = {m_VBO, m_IBO, m_attributeMask};
+    data = reinterpret_cast<const u8*>(values);
+    for (size_t i=0; i<sizeof(values); ++i)
+        key = (key ^ data[i])*1099511628211ULL;
+    m_layoutKey = key;
+}
+
+GLuint MeshObject::getVertexArray(const Shader* shader, u32 chunkIndex) const
+{
+    //vertex array objects are core from es 3.0 on, the context never changes
+    static const bool supported = esGetContextMajorVersion() >= 3;
+    if (!supported)
+        return 0;
+
+    MeshChunk chunk = this->getChunk(chunkIndex);
+    u64 shaderKey = shader->getVertexAttributeLayoutKey();
+    for (size_t i=0; i<m_vertexArrays.size(); ++i)
+    {
+        const VertexArrayEntry& entry = m_vertexArrays[i];
+        if (entry.m_shaderKey == shaderKey && entry.m_layoutKey == m_layoutKey && entry.m_baseVertex == chunk.m_baseVertex)
+            return entry.m_vertexArray;
+    }
+
+    VertexArrayEntry entry;
+    entry.m_shaderKey = shaderKey;
+    entry.m_layoutKey = m_layoutKey;
+    entry.m_baseVertex = chunk.m_baseVertex;
+    glGenVertexArrays(1, &entry.m_vertexArray);
+
+    //the index buffer binding is part of the vertex array
+    glBindVertexArray(entry.m_vertexArray);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO);
+    this->bindAttributes(shader, chunk);
+    glBindVertexArray(0);
+
+    m_vertexArrays.push_back(entry);
+    return entry.m_vertexArray;
+}
+
+void MeshObject::bindAttributes(const Shader* shader, const MeshChunk& chunk) const
+{
+    //a shader reading attributes the mesh lacks gets their constant value
+    JENNY_ASSERT((shader->getVertexAttributeMask() & ~m_attributeMask) == 0);
+
+    for (Shader::VertexAttributeIter it = shader->getVertexAttributesBegin();
+        it != shader->getVertexAttributesEnd();
+        ++it)
+    {
+        const MeshAttributeDef* meshAttribute = this->getMeshAttribute(it->attributeType);
+        if (!meshAttribute)
+            continue;
+
+        //chunks start their attributes at their base vertex
+        size_t offset = meshAttribute->m_offset + size_t(chunk.m_baseVertex)*meshAttribute->m_stride;
+        glBindBuffer(GL_ARRAY_BUFFER, meshAttribute->m_buffer ? meshAttribute->m_buffer : m_VBO);
+        glVertexAttribPointer(it->location,
+            meshAttribute->m_elementNum,
+            meshAttribute->m_elementType,
+            meshAttribute->m_normalized,
+            meshAttribute->m_stride,
+            reinterpret_cast<void*>(offset)
+            );
+        glEnableVertexAttribArray(it->location);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshObject::draw(const Shader* shader) const
+{
+    GLenum indexType = m_indexType;
+    GLenum primitiveType = m_primitiveType;
+    if (primitiveType == GL_TRIANGLE_STRIP)
+        glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+
+    //es 2 contexts set up the attributes for every draw
+    bool vertexArrays = true;
+    for (u32 i=0; i<this->getChunkCount(); ++i)
+    {
+        MeshChunk chunk = this->getChunk(i);
+
+        GLuint vertexArray = this->getVertexArray(shader, i);
+        if (vertexArray)
+        {
+            glBindVertexArray(vertexArray);
+        }
+        else
+        {
+            vertexArrays = false;
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO);
+            this->bindAttributes(shader, chunk);
+        }
+
+        glDrawElements(primitiveType, 
+            chunk.m_indexCount,
+            indexType,
+            reinterpret_cast<void*>(size_t(chunk.m_firstIndex)*getIndexTypeSize(indexType)));
+    }
+
+    if (primitiveType == GL_TRIANGLE_STRIP)
+        glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+
+    if (vertexArrays)
+    {
+        glBindVertexArray(0);
+        return;
+    }
+
+    for (auto it = shader->getVertexAttributesBegin(); 
+        it != shader->getVertexAttributesEnd(); 
+        ++it)
+    {
+        glDisableVertexAttribArray(it->location);
+    }
+}
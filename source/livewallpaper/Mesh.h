@@ -1,6 +1,6 @@
 #pragma once
 #include <GLES3/gl3.h>
-#include <unordered_map>
+#include <vector>
 #include <core/types.h>
 #include "EVertexAttribute.h"
 
@@ -10,8 +10,36 @@ struct MeshAttributeDef
 	GLenum		m_elementType;
 	GLsizei		m_stride;
 	u32 		m_offset;
+
+	//integer elements reach the shader as -1..1 or 0..1 instead of their value
+	GLboolean	m_normalized;
+
+	//buffer the attribute reads, 0 for the mesh's vbo
+	GLuint		m_buffer;
+};
+
+//! Range of the index buffer drawn with every attribute moved forward by
+//! baseVertex vertices, lets 16 bit indices address more than 65536 vertices
+//! without glDrawElementsBaseVertex.
+struct MeshChunk
+{
+	u32			m_baseVertex;
+	u32			m_firstIndex;
+	u32			m_indexCount;
 };
 
+//! Bytes per index of GL_UNSIGNED_BYTE/SHORT/INT.
+u32 getIndexTypeSize(GLenum indexType);
+
+class Shader;
+
+//! Vertex and index buffers with the layout of their attributes.
+//!
+//! Draws go through vertex array objects, one per shader attribute layout,
+//! mesh layout and chunk, built when a draw first asks for it and kept for
+//! the lifetime of the mesh. Shaders with the same attribute locations share
+//! them, and a layout that comes back, like the segments of a streamed
+//! attribute, finds its old one.
 class MeshObject
 {
 public:
@@ -28,21 +56,76 @@ public:
     void setIndexCount(u32 count);
     u32 getIndexCount() const;
 
+    //! GL_UNSIGNED_SHORT unless set
+    void setIndexType(GLenum indexType);
+    GLenum getIndexType() const;
+
+    //! GL_TRIANGLES unless set, GL_TRIANGLE_STRIP meshes separate their
+    //! strips with the fixed primitive restart index.
+    void setPrimitiveType(GLenum primitiveType);
+    GLenum getPrimitiveType() const;
+
+    //! Without added chunks there is one covering the whole index buffer.
+    void addChunk(u32 baseVertex, u32 firstIndex, u32 indexCount);
+    void clearChunks();
+    u32 getChunkCount() const;
+    MeshChunk getChunk(u32 index) const;
+
     void addMeshAttribute(const char* attributeName, 
                             GLint elementNum, 
                             GLenum elementType, 
                             GLsizei stride, 
-                            u32 offset);
+                            u32 offset,
+                            GLboolean normalized = GL_FALSE);
 	const MeshAttributeDef* getMeshAttribute(E_Vertex_Attribute attribute) const;
 
+    //! Reads an attribute from another buffer, like a segment of a
+    //! StreamingBuffer, buffer 0 reads the vbo again.
+    void setMeshAttributeSource(E_Vertex_Attribute attribute, GLuint buffer, u32 offset);
+
+    //! E_VERTEX_ATTRIBUTE_BITS of the attributes added.
+    u32 getAttributeMask() const;
+
+    //! Vertex array with the index buffer and the shader's attributes bound,
+    //! starting at the chunk's base vertex. 0 on contexts without vertex
+    //! array objects, bindAttributes() then sets up every draw.
+    GLuint getVertexArray(const Shader* shader, u32 chunkIndex) const;
+
+    //! Points the shader's attributes at the chunk's first vertex, in the
+    //! bound vertex array. Attributes the mesh lacks are left disabled.
+    void bindAttributes(const Shader* shader, const MeshChunk& chunk) const;
+
+    //! Draws every chunk with the bound program, one vertex array bind and
+    //! one glDrawElements each.
+    void draw(const Shader* shader) const;
+
 private:
-    typedef std::unordered_map<E_Vertex_Attribute,MeshAttributeDef> AttributeMap;
-    std::unordered_map<E_Vertex_Attribute,MeshAttributeDef> m_attributeMap;
+    //! m_layoutKey from the buffers and attributes
+    void _updateLayoutKey();
+
+private:
+    MeshAttributeDef m_attributes[static_cast<int>(E_Vertex_Attribute::EVA_COUNT)];
+    u32 m_attributeMask;
+    u64 m_layoutKey;
+
+    struct VertexArrayEntry
+    {
+        u64 m_shaderKey;
+        u64 m_layoutKey;
+        u32 m_baseVertex;
+        GLuint m_vertexArray;
+    };
+
+    //filled by draws, which only read the mesh otherwise
+    mutable std::vector<VertexArrayEntry> m_vertexArrays;
 
 	GLuint m_VBO;
 	GLuint m_IBO;
 
     u32 m_indexCount;
+    GLenum m_indexType;
+    GLenum m_primitiveType;
+    std::vector<MeshChunk> m_chunks;
 };
 
 
@@ -50,6 +133,7 @@ inline void
 MeshObject::setVBO(GLuint vbo)
 {
     this->m_VBO = vbo;
+    this->_updateLayoutKey();
 }
 
 inline GLuint 
@@ -68,6 +152,7 @@ inline void
 MeshObject::setIBO(GLuint ibo)
 {
     this->m_IBO = ibo;
+    this->_updateLayoutKey();
 }
 
 inline void 
@@ -81,3 +166,56 @@ MeshObject::getIndexCount() const
 {
     return m_indexCount;
 }
+
+inline void
+MeshObject::setIndexType(GLenum indexType)
+{
+    m_indexType = indexType;
+}
+
+inline GLenum
+MeshObject::getIndexType() const
+{
+    return m_indexType;
+}
+
+inline void
+MeshObject::setPrimitiveType(GLenum primitiveType)
+{
+    m_primitiveType = primitiveType;
+}
+
+inline GLenum
+MeshObject::getPrimitiveType() const
+{
+    return m_primitiveType;
+}
+
+inline u32
+MeshObject::getAttributeMask() const
+{
+    return m_attributeMask;
+}
+
+inline void
+MeshObject::clearChunks()
+{
+    m_chunks.clear();
+}
+
+inline u32
+MeshObject::getChunkCount() const
+{
+    return m_chunks.empty() ? 1 : u32(m_chunks.size());
+}
+
+inline MeshChunk
+MeshObject::getChunk(u32 index) const
+{
+    if (m_chunks.empty())
+    {
+        MeshChunk whole = {0, 0, m_indexCount};
+        return whole;
+    }
+    return m_chunks[index];
+}
@@ -0,0 +1,118 @@
+#include "QualityGovernor.h"
+#include <algorithm>
+
+//frames averaged before the governor acts
+static const int GOVERNOR_WINDOW_FRAMES = 60;
+
+//average load that makes the governor step down, a little under budget so
+//the odd slow frame does not miss vsync
+static const float GOVERNOR_STEP_DOWN_LOAD = 0.9f;
+
+//load the next better tier is expected to run at before the governor steps
+//up, under the step down load so a cost estimate that is a bit off does not
+//step right back down
+static const float GOVERNOR_STEP_UP_LOAD = 0.7f;
+
+//frames of headroom before stepping up
+static const int GOVERNOR_STEP_UP_FRAMES = 4*GOVERNOR_WINDOW_FRAMES;
+
+//every time a tier runs over budget again, stepping back up to it waits
+//twice as long, up to about nine minutes at 60 frames a second
+static const int GOVERNOR_MAX_STEP_UP_FRAMES = 512*GOVERNOR_WINDOW_FRAMES;
+
+//best first, the second tier matches the WaterSettings defaults
+static const QualityTier DEFAULT_TIERS[] =
+{
+	{2, 0, 60},
+	{3, 0, 60},
+	{4, 0, 60},
+	{4, 1, 60},
+	{6, 1, 30},
+};
+static const int DEFAULT_START_TIER = 1;
+
+//simulated cells per second, what grows most from one tier to the better one:
+//3 to 2 pixel cells is 2.25 times the cells, 4 to 3 is 1.78 times
+static float getTierCost(const QualityTier& tier)
+{
+	return float(tier.simulationRate)/float(tier.cellSize*tier.cellSize);
+}
+
+QualityGovernor::QualityGovernor():m_tier(0)
+	,m_loadCount(0)
+	,m_nextLoad(0)
+	,m_loadSum(0.0f)
+	,m_calmFrames(0)
+{
+	m_loads.resize(GOVERNOR_WINDOW_FRAMES);
+	this->SetTiers(DEFAULT_TIERS, sizeof(DEFAULT_TIERS)/sizeof(DEFAULT_TIERS[0]), DEFAULT_START_TIER);
+}
+
+void QualityGovernor::SetTiers(const QualityTier* tiers, int count, int startTier)
+{
+	m_tiers.assign(tiers, tiers + count);
+	m_stepUpFrames.assign(count, GOVERNOR_STEP_UP_FRAMES);
+	this->SetTier(startTier);
+}
+
+void QualityGovernor::SetTier(int tier)
+{
+	m_tier = std::min(std::max(tier, 0), int(m_tiers.size()) - 1);
+	this->_resetWindow();
+}
+
+bool QualityGovernor::AddFrame(float load)
+{
+	if (m_loadCount == GOVERNOR_WINDOW_FRAMES)
+		m_loadSum -= m_loads[m_nextLoad];
+	else
+		++m_loadCount;
+
+	m_loads[m_nextLoad] = load;
+	m_loadSum += load;
+	m_nextLoad = (m_nextLoad + 1)%GOVERNOR_WINDOW_FRAMES;
+
+	//resum once per window so rounding errors do not pile up
+	if (m_nextLoad == 0 && m_loadCount == GOVERNOR_WINDOW_FRAMES)
+	{
+		m_loadSum = 0.0f;
+		for (int i=0; i<GOVERNOR_WINDOW_FRAMES; ++i)
+			m_loadSum += m_loads[i];
+	}
+
+	if (m_loadCount < GOVERNOR_WINDOW_FRAMES)
+		return false;
+
+	float average = m_loadSum/GOVERNOR_WINDOW_FRAMES;
+	if (average > GOVERNOR_STEP_DOWN_LOAD && m_tier + 1 < int(m_tiers.size()))
+	{
+		//the tier does not fit, back off before trying it again
+		int& backoff = m_stepUpFrames[m_tier];
+		backoff = std::min(2*backoff, GOVERNOR_MAX_STEP_UP_FRAMES);
+
+		this->SetTier(m_tier + 1);
+		return true;
+	}
+
+	if (m_tier == 0)
+		return false;
+
+	//the load of the better tier, assuming the whole frame grows with its cost
+	float expected = average*getTierCost(m_tiers[m_tier - 1])/getTierCost(m_tiers[m_tier]);
+	m_calmFrames = (expected < GOVERNOR_STEP_UP_LOAD) ? m_calmFrames + 1 : 0;
+	if (m_calmFrames >= m_stepUpFrames[m_tier - 1])
+	{
+		this->SetTier(m_tier - 1);
+		return true;
+	}
+	return false;
+}
+
+void QualityGovernor::_resetWindow()
+{
+	//the frames of the old tier say nothing about the new one
+	m_loadCount = 0;
+	m_nextLoad = 0;
+	m_loadSum = 0.0f;
+	m_calmFrames = 0;
+}
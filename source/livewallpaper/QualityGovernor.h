@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <core/types.h>
+
+//! One step of the quality ladder.
+struct QualityTier
+{
+	//screen pixels per simulation cell, see WaterSettings::cellSize
+	int		cellSize;
+
+	//water mesh level, see Water::SetMeshLod()
+	int		meshLod;
+
+	//simulation steps per second
+	int		simulationRate;
+};
+
+//! Picks the quality tier from the measured load of the last frames.
+//!
+//! The load of a frame is the share of the frame budget it used, 1 is exactly
+//! on budget. Once the average over a full window of frames runs over budget
+//! the governor steps down one tier at once. It only steps back up after
+//! several windows in a row left enough headroom for the better tier, scaled
+//! by how much more that tier costs, so a tier that barely fits is not
+//! toggled every second. A tier that ran over budget has to wait twice as long
+//! each time before it is tried again. Every change starts a new window.
+//!
+//! Tier 0 is the best looking, the last one the cheapest.
+class QualityGovernor
+{
+public:
+	//! The default ladder, starting on the tier of the WaterSettings defaults.
+	QualityGovernor();
+
+	void SetTiers(const QualityTier* tiers, int count, int startTier);
+	void SetTier(int tier);
+
+	//! Returns true when the tier changed.
+	bool AddFrame(float load);
+
+	int GetTier() const;
+	int GetTierCount() const;
+	const QualityTier& GetTierSettings(int tier) const;
+
+private:
+	void _resetWindow();
+
+	std::vector<QualityTier>	m_tiers;
+	int							m_tier;
+
+	//rolling window of frame loads and their sum
+	std::vector<float>			m_loads;
+	int							m_loadCount;
+	int							m_nextLoad;
+	float						m_loadSum;
+
+	//frames in a row the window average left room for the better tier
+	int							m_calmFrames;
+
+	//per tier, frames of headroom needed before stepping up to it
+	std::vector<int>			m_stepUpFrames;
+};
+
+inline int
+QualityGovernor::GetTier() const
+{
+	return m_tier;
+}
+
+inline int
+QualityGovernor::GetTierCount() const
+{
+	return int(m_tiers.size());
+}
+
+inline const QualityTier&
+QualityGovernor::GetTierSettings(int tier) const
+{
+	return m_tiers[tier];
+}
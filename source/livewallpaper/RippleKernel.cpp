@@ -0,0 +1,341 @@
+#include "RippleKernel.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define RIPPLE_KERNEL_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define RIPPLE_KERNEL_X86 0
+#endif
+
+// gcc/clang only emit AVX2 code for functions that ask for it, msvc emits
+// whatever intrinsics it is given.
+#if defined(__GNUC__)
+#define RIPPLE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RIPPLE_TARGET_AVX2
+#endif
+
+const float RIPPLE_DAMPING_FACTOR = 0.04f;
+const int RIPPLE_HEIGHT16_MAX = 32767;
+const int RIPPLE_HEIGHT16_MIN = -32767;
+
+static void rippleRowScalar(const int* heightRead, int* heightWrite, int count, int stride)
+{
+	const int* r = heightRead;
+	for (int i=0; i<count; ++i, ++r)
+	{
+		float value = (float)(
+			r[-2] +
+			r[2] +
+			r[-2*stride] +
+			r[2*stride] +
+			r[-1] +
+			r[1] +
+			r[-stride] +
+			r[stride] +
+			r[-stride-1] +
+			r[-stride+1] +
+			r[stride-1] +
+			r[stride+1]);
+
+		value /= 6.0f;
+		value -= (float)heightWrite[i];
+		value -= (value*RIPPLE_DAMPING_FACTOR);
+
+		heightWrite[i] = (int)value;
+	}
+}
+
+static void rippleRowScalar16(const s16* heightRead, s16* heightWrite, int count, int stride)
+{
+	const s16* r = heightRead;
+	for (int i=0; i<count; ++i, ++r)
+	{
+		float value = (float)(
+			r[-2] +
+			r[2] +
+			r[-2*stride] +
+			r[2*stride] +
+			r[-1] +
+			r[1] +
+			r[-stride] +
+			r[stride] +
+			r[-stride-1] +
+			r[-stride+1] +
+			r[stride-1] +
+			r[stride+1]);
+
+		value /= 6.0f;
+		value -= (float)heightWrite[i];
+		value -= (value*RIPPLE_DAMPING_FACTOR);
+
+		int result = (int)value;
+		if (result > RIPPLE_HEIGHT16_MAX)
+			result = RIPPLE_HEIGHT16_MAX;
+		if (result < RIPPLE_HEIGHT16_MIN)
+			result = RIPPLE_HEIGHT16_MIN;
+		heightWrite[i] = (s16)result;
+	}
+}
+
+#if RIPPLE_KERNEL_X86
+
+static inline __m128i rippleSum4(const int* r, int stride)
+{
+	__m128i a = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(r - 2)), _mm_loadu_si128((const __m128i*)(r + 2)));
+	__m128i b = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(r - 2*stride)), _mm_loadu_si128((const __m128i*)(r + 2*stride)));
+	__m128i c = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(r - 1)), _mm_loadu_si128((const __m128i*)(r + 1)));
+	__m128i d = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(r - stride)), _mm_loadu_si128((const __m128i*)(r + stride)));
+	__m128i e = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(r - stride - 1)), _mm_loadu_si128((const __m128i*)(r - stride + 1)));
+	__m128i f = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(r + stride - 1)), _mm_loadu_si128((const __m128i*)(r + stride + 1)));
+	return _mm_add_epi32(_mm_add_epi32(_mm_add_epi32(a, b), _mm_add_epi32(c, d)), _mm_add_epi32(e, f));
+}
+
+static inline __m128i rippleStep4(__m128i sum, __m128i previous)
+{
+	const __m128 sixth = _mm_set1_ps(6.0f);
+	const __m128 damping = _mm_set1_ps(RIPPLE_DAMPING_FACTOR);
+
+	__m128 value = _mm_div_ps(_mm_cvtepi32_ps(sum), sixth);
+	value = _mm_sub_ps(value, _mm_cvtepi32_ps(previous));
+	value = _mm_sub_ps(value, _mm_mul_ps(value, damping));
+	return _mm_cvttps_epi32(value);
+}
+
+static void rippleRowSSE2(const int* heightRead, int* heightWrite, int count, int stride)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const int* r = heightRead + i;
+		__m128i sum0 = rippleSum4(r, stride);
+		__m128i sum1 = rippleSum4(r + 4, stride);
+		__m128i prev0 = _mm_loadu_si128((const __m128i*)(heightWrite + i));
+		__m128i prev1 = _mm_loadu_si128((const __m128i*)(heightWrite + i + 4));
+		_mm_storeu_si128((__m128i*)(heightWrite + i), rippleStep4(sum0, prev0));
+		_mm_storeu_si128((__m128i*)(heightWrite + i + 4), rippleStep4(sum1, prev1));
+	}
+
+	if (i < count)
+		rippleRowScalar(heightRead + i, heightWrite + i, count - i, stride);
+}
+
+//sign extends 8 heights to two vectors of 4 ints
+static inline void rippleLoad8x16(const s16* p, __m128i& low, __m128i& high)
+{
+	__m128i v = _mm_loadu_si128((const __m128i*)p);
+	low = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+	high = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+}
+
+static inline void rippleSum8x16(const s16* r, int stride, __m128i& low, __m128i& high)
+{
+	const s16* taps[12] =
+	{
+		r - 2, r + 2, r - 2*stride, r + 2*stride,
+		r - 1, r + 1, r - stride, r + stride,
+		r - stride - 1, r - stride + 1, r + stride - 1, r + stride + 1
+	};
+
+	rippleLoad8x16(taps[0], low, high);
+	for (int i=1; i<12; ++i)
+	{
+		__m128i tapLow, tapHigh;
+		rippleLoad8x16(taps[i], tapLow, tapHigh);
+		low = _mm_add_epi32(low, tapLow);
+		high = _mm_add_epi32(high, tapHigh);
+	}
+}
+
+static void rippleRowSSE2_16(const s16* heightRead, s16* heightWrite, int count, int stride)
+{
+	const __m128i heightMin = _mm_set1_epi16((s16)RIPPLE_HEIGHT16_MIN);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i sumLow, sumHigh, prevLow, prevHigh;
+		rippleSum8x16(heightRead + i, stride, sumLow, sumHigh);
+		rippleLoad8x16(heightWrite + i, prevLow, prevHigh);
+
+		//packs saturates like the scalar clamp, except that it lets -32768 through
+		__m128i result = _mm_packs_epi32(rippleStep4(sumLow, prevLow), rippleStep4(sumHigh, prevHigh));
+		result = _mm_max_epi16(result, heightMin);
+		_mm_storeu_si128((__m128i*)(heightWrite + i), result);
+	}
+
+	if (i < count)
+		rippleRowScalar16(heightRead + i, heightWrite + i, count - i, stride);
+}
+
+RIPPLE_TARGET_AVX2 static inline __m256i rippleSum8(const int* r, int stride)
+{
+	__m256i a = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(r - 2)), _mm256_loadu_si256((const __m256i*)(r + 2)));
+	__m256i b = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(r - 2*stride)), _mm256_loadu_si256((const __m256i*)(r + 2*stride)));
+	__m256i c = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(r - 1)), _mm256_loadu_si256((const __m256i*)(r + 1)));
+	__m256i d = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(r - stride)), _mm256_loadu_si256((const __m256i*)(r + stride)));
+	__m256i e = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(r - stride - 1)), _mm256_loadu_si256((const __m256i*)(r - stride + 1)));
+	__m256i f = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(r + stride - 1)), _mm256_loadu_si256((const __m256i*)(r + stride + 1)));
+	return _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(a, b), _mm256_add_epi32(c, d)), _mm256_add_epi32(e, f));
+}
+
+RIPPLE_TARGET_AVX2 static inline __m256i rippleStep8(__m256i sum, __m256i previous)
+{
+	const __m256 sixth = _mm256_set1_ps(6.0f);
+	const __m256 damping = _mm256_set1_ps(RIPPLE_DAMPING_FACTOR);
+
+	// mul and sub stay separate, a fused multiply-add would round differently
+	// from the scalar path
+	__m256 value = _mm256_div_ps(_mm256_cvtepi32_ps(sum), sixth);
+	value = _mm256_sub_ps(value, _mm256_cvtepi32_ps(previous));
+	value = _mm256_sub_ps(value, _mm256_mul_ps(value, damping));
+	return _mm256_cvttps_epi32(value);
+}
+
+RIPPLE_TARGET_AVX2 static void rippleRowAVX2(const int* heightRead, int* heightWrite, int count, int stride)
+{
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const int* r = heightRead + i;
+		__m256i sum0 = rippleSum8(r, stride);
+		__m256i sum1 = rippleSum8(r + 8, stride);
+		__m256i prev0 = _mm256_loadu_si256((const __m256i*)(heightWrite + i));
+		__m256i prev1 = _mm256_loadu_si256((const __m256i*)(heightWrite + i + 8));
+		_mm256_storeu_si256((__m256i*)(heightWrite + i), rippleStep8(sum0, prev0));
+		_mm256_storeu_si256((__m256i*)(heightWrite + i + 8), rippleStep8(sum1, prev1));
+	}
+	_mm256_zeroupper();
+
+	if (i < count)
+		rippleRowSSE2(heightRead + i, heightWrite + i, count - i, stride);
+}
+
+RIPPLE_TARGET_AVX2 static inline __m256i rippleLoad8x16AVX2(const s16* p)
+{
+	return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)p));
+}
+
+RIPPLE_TARGET_AVX2 static inline __m256i rippleSum8x16AVX2(const s16* r, int stride)
+{
+	__m256i a = _mm256_add_epi32(rippleLoad8x16AVX2(r - 2), rippleLoad8x16AVX2(r + 2));
+	__m256i b = _mm256_add_epi32(rippleLoad8x16AVX2(r - 2*stride), rippleLoad8x16AVX2(r + 2*stride));
+	__m256i c = _mm256_add_epi32(rippleLoad8x16AVX2(r - 1), rippleLoad8x16AVX2(r + 1));
+	__m256i d = _mm256_add_epi32(rippleLoad8x16AVX2(r - stride), rippleLoad8x16AVX2(r + stride));
+	__m256i e = _mm256_add_epi32(rippleLoad8x16AVX2(r - stride - 1), rippleLoad8x16AVX2(r - stride + 1));
+	__m256i f = _mm256_add_epi32(rippleLoad8x16AVX2(r + stride - 1), rippleLoad8x16AVX2(r + stride + 1));
+	return _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(a, b), _mm256_add_epi32(c, d)), _mm256_add_epi32(e, f));
+}
+
+RIPPLE_TARGET_AVX2 static void rippleRowAVX2_16(const s16* heightRead, s16* heightWrite, int count, int stride)
+{
+	const __m256i heightMin = _mm256_set1_epi16((s16)RIPPLE_HEIGHT16_MIN);
+
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const s16* r = heightRead + i;
+		__m256i step0 = rippleStep8(rippleSum8x16AVX2(r, stride), rippleLoad8x16AVX2(heightWrite + i));
+		__m256i step1 = rippleStep8(rippleSum8x16AVX2(r + 8, stride), rippleLoad8x16AVX2(heightWrite + i + 8));
+
+		//packs works per 128 bit lane, put the quads back in order
+		__m256i result = _mm256_permute4x64_epi64(_mm256_packs_epi32(step0, step1), 0xD8);
+		result = _mm256_max_epi16(result, heightMin);
+		_mm256_storeu_si256((__m256i*)(heightWrite + i), result);
+	}
+	_mm256_zeroupper();
+
+	if (i < count)
+		rippleRowSSE2_16(heightRead + i, heightWrite + i, count - i, stride);
+}
+
+static bool cpuSupportsAVX2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// AVX2 needs the OS to save the ymm registers as well
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx)
+		return false;
+	if ((_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#else
+	return false;
+#endif
+}
+
+#endif
+
+E_Ripple_Kernel detectRippleKernel()
+{
+#if RIPPLE_KERNEL_X86
+	if (cpuSupportsAVX2())
+		return ERK_AVX2;
+
+	// every x86 cpu we can run on has SSE2
+	return ERK_SSE2;
+#else
+	return ERK_SCALAR;
+#endif
+}
+
+RippleRowFunc getRippleRowFunc(E_Ripple_Kernel kernel)
+{
+	switch (kernel)
+	{
+#if RIPPLE_KERNEL_X86
+	case ERK_SSE2:		return rippleRowSSE2;
+	case ERK_AVX2:		return rippleRowAVX2;
+#endif
+	default:			return rippleRowScalar;
+	}
+}
+
+RippleRowFunc16 getRippleRowFunc16(E_Ripple_Kernel kernel)
+{
+	switch (kernel)
+	{
+#if RIPPLE_KERNEL_X86
+	case ERK_SSE2:		return rippleRowSSE2_16;
+	case ERK_AVX2:		return rippleRowAVX2_16;
+#endif
+	default:			return rippleRowScalar16;
+	}
+}
+
+const char* getRippleKernelName(E_Ripple_Kernel kernel)
+{
+	switch (kernel)
+	{
+	case ERK_SCALAR:	return "scalar";
+	case ERK_SSE2:		return "sse2";
+	case ERK_AVX2:		return "avx2";
+	default:			return "unknown";
+	}
+}
+
+const char* getRipplePrecisionName(E_Ripple_Precision precision)
+{
+	switch (precision)
+	{
+	case ERP_INT32:		return "int32";
+	case ERP_INT16:		return "int16";
+	default:			return "unknown";
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <core/types.h>
+
+//! Height field stencil used by the CPU water solver.
+//!
+//! For every cell the 12 neighbours (the 4 at distance 2, the 8 surrounding
+//! cells) are summed as ints, divided by 6, the previous height is subtracted
+//! and the damping factor is applied, truncating back to int. All kernels give
+//! bit-identical results to the scalar one.
+//!
+//! The 16 bit variants run the same arithmetic on s16 heights and saturate the
+//! result to +-32767, which halves the memory traffic of the pass. Both storage
+//! formats step to the same values as long as the heights stay inside that
+//! range. The int kernels never clamp, sustained input such as rain drives
+//! them past it and the s16 field drifts away from there on.
+
+enum E_Ripple_Kernel
+{
+	ERK_SCALAR = 0,
+	ERK_SSE2,
+	ERK_AVX2,
+
+	ERK_COUNT,
+};
+
+//! Storage of one height.
+enum E_Ripple_Precision
+{
+	ERP_INT32 = 0,
+	ERP_INT16,
+
+	ERP_COUNT,
+};
+
+//! Runs the stencil over `count` consecutive cells of one row.
+//! heightRead/heightWrite point at the first cell to process, stride is the
+//! row pitch in cells. heightWrite holds the previous heights on entry.
+typedef void (*RippleRowFunc)(const int* heightRead, int* heightWrite, int count, int stride);
+typedef void (*RippleRowFunc16)(const s16* heightRead, s16* heightWrite, int count, int stride);
+
+extern const float RIPPLE_DAMPING_FACTOR;
+
+//! Range the 16 bit kernels and Resample() saturate s16 heights to, symmetric
+//! so negating a wave never overflows.
+extern const int RIPPLE_HEIGHT16_MAX;
+extern const int RIPPLE_HEIGHT16_MIN;
+
+//! Best kernel supported by the running CPU.
+E_Ripple_Kernel detectRippleKernel();
+
+RippleRowFunc getRippleRowFunc(E_Ripple_Kernel kernel);
+RippleRowFunc16 getRippleRowFunc16(E_Ripple_Kernel kernel);
+
+const char* getRippleKernelName(E_Ripple_Kernel kernel);
+const char* getRipplePrecisionName(E_Ripple_Precision precision);
@@ -0,0 +1,690 @@
+#include "RippleSimulation.h"
+#include <core/WorkerPool.h>
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+#include <string.h>
+
+static const int RIPPLE_MIN_BAND_ROWS = 16;
+static const int RIPPLE_BANDS_PER_THREAD = 4;
+
+//texture coordinate distance of one unit of height difference, one pixel of
+//the 512 water texture is two units
+static const float UV_OFFSET_PER_HEIGHT = 0.5f/512.0f;
+
+const char* getUVFormatName(E_UV_Format format)
+{
+	switch (format)
+	{
+	case EUF_FLOAT:		return "float";
+	case EUF_INT16:		return "int16";
+	case EUF_INT8:		return "int8";
+	default:			return "unknown";
+	}
+}
+
+int getUVFormatSize(E_UV_Format format)
+{
+	switch (format)
+	{
+	case EUF_INT16:		return 2*sizeof(s16);
+	case EUF_INT8:		return 2*sizeof(s8);
+	default:			return 2*sizeof(float);
+	}
+}
+
+float getUVOffsetScale(E_UV_Format format)
+{
+	switch (format)
+	{
+	case EUF_INT16:		return 32767.0f*UV_OFFSET_PER_HEIGHT;
+	case EUF_INT8:		return 127.0f*2.0f*UV_OFFSET_PER_HEIGHT;
+	default:			return UV_OFFSET_PER_HEIGHT;
+	}
+}
+
+//wider than the two cell reach of the stencil, so only direct neighbours of a
+//tile can wake it up
+static const int RIPPLE_TILE_SIZE = 32;
+
+RippleSimulation::RippleSimulation(int width, int height, int threadCount, E_Ripple_Precision precision,
+	E_UV_Format uvFormat):m_width(width)
+	,m_height(height)
+	,m_bandCount(1)
+	,m_bandRows(height)
+	,m_pHightRead(nullptr)
+	,m_pHightWrite(nullptr)
+	,m_pUVBufferWrite(nullptr)
+	,m_uvHeights(nullptr)
+	,m_tilesX(0)
+	,m_tilesY(0)
+	,m_activeTileCount(0)
+	,m_precision(precision)
+	,m_uvFormat(uvFormat)
+	,m_kernel(ERK_SCALAR)
+	,m_rippleRow(nullptr)
+	,m_rippleRow16(nullptr)
+	,m_workerPool(nullptr)
+{
+	m_kernel = detectRippleKernel();
+	m_rippleRow = getRippleRowFunc(m_kernel);
+	m_rippleRow16 = getRippleRowFunc16(m_kernel);
+
+	int cellCount = m_width*m_height;
+	int cellSize = (m_precision == ERP_INT16) ? sizeof(s16) : sizeof(int);
+	m_pHightRead = new u8[cellCount*cellSize];
+	m_pHightWrite = new u8[cellCount*cellSize];
+	memset(m_pHightRead, 0, cellCount*cellSize);
+	memset(m_pHightWrite, 0, cellCount*cellSize);
+
+	m_tilesX = (m_width + RIPPLE_TILE_SIZE - 1)/RIPPLE_TILE_SIZE;
+	m_tilesY = (m_height + RIPPLE_TILE_SIZE - 1)/RIPPLE_TILE_SIZE;
+	m_tileActive.assign(m_tilesX*m_tilesY, 0);
+	m_tileSimulate.assign(m_tilesX*m_tilesY, 0);
+
+	m_workerPool = new WorkerPool(threadCount);
+
+	//bands own whole tile rows, so each band updates its own tiles
+	int maxBands = std::max(1, m_height/RIPPLE_MIN_BAND_ROWS);
+	m_bandCount = std::min(maxBands, m_workerPool->getThreadCount()*RIPPLE_BANDS_PER_THREAD);
+	m_bandRows = (m_height + m_bandCount - 1)/m_bandCount;
+	m_bandRows = (m_bandRows + RIPPLE_TILE_SIZE - 1)/RIPPLE_TILE_SIZE*RIPPLE_TILE_SIZE;
+	m_bandCount = (m_height + m_bandRows - 1)/m_bandRows;
+}
+
+RippleSimulation::~RippleSimulation()
+{
+	delete m_workerPool;
+
+	delete[] static_cast<u8*>(m_pHightRead);
+	delete[] static_cast<u8*>(m_pHightWrite);
+}
+
+int RippleSimulation::GetThreadCount() const
+{
+	return m_workerPool->getThreadCount();
+}
+
+int RippleSimulation::GetHeightAt(int x, int y) const
+{
+	if (m_precision == ERP_INT16)
+		return static_cast<const s16*>(m_pHightRead)[y*m_width + x];
+	return static_cast<const int*>(m_pHightRead)[y*m_width + x];
+}
+
+double RippleSimulation::GetEnergy() const
+{
+	double energy = 0.0;
+	for (int y=0; y<m_height; ++y)
+	{
+		for (int x=0; x<m_width; ++x)
+		{
+			double value = this->GetHeightAt(x, y);
+			energy += value*value;
+		}
+	}
+	return energy;
+}
+
+u64 RippleSimulation::GetHeightChecksum() const
+{
+	u64 hash = 14695981039346656037ULL;
+	for (int y=0; y<m_height; ++y)
+	{
+		for (int x=0; x<m_width; ++x)
+		{
+			u32 value = u32(this->GetHeightAt(x, y));
+			for (int byte=0; byte<4; ++byte)
+			{
+				hash ^= (value >> (byte*8)) & 0xff;
+				hash *= 1099511628211ULL;
+			}
+		}
+	}
+	return hash;
+}
+
+RowRange RippleSimulation::GetStepRows() const
+{
+	int firstTileRow = m_tilesY;
+	int lastTileRow = -1;
+	for (int ty=0; ty<m_tilesY; ++ty)
+	{
+		for (int tx=0; tx<m_tilesX; ++tx)
+		{
+			if (m_tileActive[ty*m_tilesX + tx])
+			{
+				firstTileRow = std::min(firstTileRow, ty);
+				lastTileRow = ty;
+				break;
+			}
+		}
+	}
+
+	if (lastTileRow < 0)
+		return RowRange();
+
+	//the step reaches one tile further, the coordinates one more row
+	return RowRange(std::max(0, (firstTileRow - 1)*RIPPLE_TILE_SIZE - 1),
+		std::min(m_height, (lastTileRow + 2)*RIPPLE_TILE_SIZE + 1));
+}
+
+RowRange RippleSimulation::Step()
+{
+	return this->Step(nullptr, RowRange());
+}
+
+RowRange RippleSimulation::Step(void* uvRows, const RowRange& rows)
+{
+	//flat water stays flat
+	if (m_activeTileCount == 0)
+	{
+		m_activeRows = RowRange();
+		this->WriteUV(uvRows, rows);
+		return m_activeRows;
+	}
+
+	m_uvSourceRows = this->GetStepRows();
+	for (int ty=0; ty<m_tilesY; ++ty)
+	{
+		for (int tx=0; tx<m_tilesX; ++tx)
+		{
+			u8 simulate = 0;
+			for (int ny=std::max(0, ty - 1); ny<=std::min(m_tilesY - 1, ty + 1); ++ny)
+			{
+				for (int nx=std::max(0, tx - 1); nx<=std::min(m_tilesX - 1, tx + 1); ++nx)
+					simulate |= m_tileActive[ny*m_tilesX + nx];
+			}
+			m_tileSimulate[ty*m_tilesX + tx] = simulate;
+		}
+	}
+
+	//bands write the coordinates of their inner rows right behind the
+	//stencil, the rows on band edges need the neighbour band's heights
+	m_pUVBufferWrite = static_cast<u8*>(uvRows);
+	m_uvRows = uvRows ? rows : RowRange();
+	m_uvHeights = m_pHightWrite;
+
+	m_workerPool->run(&RippleSimulation::_stencilBand, this, m_bandCount);
+	if (!m_uvRows.isEmpty())
+		m_workerPool->run(&RippleSimulation::_uvEdgeBand, this, m_bandCount);
+
+	m_pUVBufferWrite = nullptr;
+	m_uvRows = RowRange();
+
+	//swap data
+	std::swap(m_pHightRead, m_pHightWrite);
+
+	this->_countActiveTiles();
+	return m_activeRows;
+}
+
+void RippleSimulation::_countActiveTiles()
+{
+	int firstTileRow = m_tilesY;
+	int lastTileRow = -1;
+	m_activeTileCount = 0;
+	for (int ty=0; ty<m_tilesY; ++ty)
+	{
+		for (int tx=0; tx<m_tilesX; ++tx)
+		{
+			if (m_tileActive[ty*m_tilesX + tx])
+			{
+				++m_activeTileCount;
+				firstTileRow = std::min(firstTileRow, ty);
+				lastTileRow = ty;
+			}
+		}
+	}
+
+	//coordinates look one cell past the heights
+	if (m_activeTileCount > 0)
+	{
+		m_activeRows = RowRange(std::max(0, firstTileRow*RIPPLE_TILE_SIZE - 1),
+			std::min(m_height, (lastTileRow + 1)*RIPPLE_TILE_SIZE + 1));
+	}
+	else
+	{
+		m_activeRows = RowRange();
+	}
+}
+
+void RippleSimulation::WriteUV(void* uvRows, const RowRange& rows)
+{
+	if (!uvRows || rows.isEmpty())
+		return;
+
+	m_pUVBufferWrite = static_cast<u8*>(uvRows);
+	m_uvRows = rows;
+	m_uvHeights = m_pHightRead;
+	m_uvSourceRows = m_activeRows;
+
+	m_workerPool->run(&RippleSimulation::_uvBand, this, m_bandCount);
+
+	m_pUVBufferWrite = nullptr;
+	m_uvRows = RowRange();
+}
+
+void RippleSimulation::_getBandRows(int band, int& rowBegin, int& rowEnd) const
+{
+	rowBegin = band*m_bandRows;
+	rowEnd = std::min(m_height, rowBegin + m_bandRows);
+}
+
+void RippleSimulation::_stencilBand(void* context, int band)
+{
+	RippleSimulation* sim = reinterpret_cast<RippleSimulation*>(context);
+	if (sim->m_precision == ERP_INT16)
+		sim->_stencilRows<s16>(band);
+	else
+		sim->_stencilRows<int>(band);
+}
+
+template<typename T>
+void RippleSimulation::_stencilRows(int band)
+{
+	const int width = m_width;
+	const int height = m_height;
+	const int tilesX = m_tilesX;
+	T* heightRead = static_cast<T*>(m_pHightRead);
+	T* heightWrite = static_cast<T*>(m_pHightWrite);
+
+	int rowBegin, rowEnd;
+	this->_getBandRows(band, rowBegin, rowEnd);
+
+	//inner rows of the band get their coordinates one row behind the stencil
+	RowRange uvRows(std::max(rowBegin + 1, m_uvRows.begin), std::min(rowEnd - 1, m_uvRows.end));
+
+	for (int j=rowBegin; j<rowEnd; ++j)
+	{
+		//step the runs of tiles near waves, everything else is zero and stays zero
+		const u8* simulate = &m_tileSimulate[j/RIPPLE_TILE_SIZE*tilesX];
+		int tx = 0;
+		while (j >= 2 && j < height - 2 && tx < tilesX)
+		{
+			if (!simulate[tx])
+			{
+				++tx;
+				continue;
+			}
+
+			int runBegin = tx;
+			while (tx < tilesX && simulate[tx])
+				++tx;
+
+			int x0 = std::max(2, runBegin*RIPPLE_TILE_SIZE);
+			int x1 = std::min(width - 2, tx*RIPPLE_TILE_SIZE);
+			if (x1 > x0)
+			{
+				int offset = j*width + x0;
+				_rippleRow(heightRead + offset, heightWrite + offset, x1 - x0);
+			}
+		}
+
+		//row j - 1 has both neighbours now, while they are still in cache
+		if (j - 1 >= uvRows.begin && j - 1 < uvRows.end)
+			this->_writeUVRow(heightWrite, j - 1);
+	}
+
+	//a tile stays awake while either buffer holds a wave
+	const T* heightNew = heightWrite;
+	const T* heightOld = heightRead;
+	for (int ty=rowBegin/RIPPLE_TILE_SIZE; ty*RIPPLE_TILE_SIZE<rowEnd; ++ty)
+	{
+		int y0 = ty*RIPPLE_TILE_SIZE;
+		int y1 = std::min(height, y0 + RIPPLE_TILE_SIZE);
+		for (int tx=0; tx<tilesX; ++tx)
+		{
+			int index = ty*tilesX + tx;
+			u8 active = 0;
+			if (m_tileSimulate[index])
+			{
+				int x0 = tx*RIPPLE_TILE_SIZE;
+				int x1 = std::min(width, x0 + RIPPLE_TILE_SIZE);
+				for (int y=y0; y<y1 && !active; ++y)
+				{
+					for (int x=x0; x<x1; ++x)
+					{
+						if (heightNew[y*width + x] | heightOld[y*width + x])
+						{
+							active = 1;
+							break;
+						}
+					}
+				}
+			}
+			m_tileActive[index] = active;
+		}
+	}
+}
+
+void RippleSimulation::_uvBand(void* context, int band)
+{
+	RippleSimulation* sim = reinterpret_cast<RippleSimulation*>(context);
+
+	int rowBegin, rowEnd;
+	sim->_getBandRows(band, rowBegin, rowEnd);
+	rowBegin = std::max(rowBegin, sim->m_uvRows.begin);
+	rowEnd = std::min(rowEnd, sim->m_uvRows.end);
+
+	for (int j=rowBegin; j<rowEnd; j++)
+		sim->_writeUVRow(j);
+}
+
+void RippleSimulation::_uvEdgeBand(void* context, int band)
+{
+	RippleSimulation* sim = reinterpret_cast<RippleSimulation*>(context);
+	const RowRange& rows = sim->m_uvRows;
+
+	int rowBegin, rowEnd;
+	sim->_getBandRows(band, rowBegin, rowEnd);
+
+	if (rowBegin >= rows.begin && rowBegin < rows.end)
+		sim->_writeUVRow(rowBegin);
+	if (rowEnd - 1 != rowBegin && rowEnd - 1 >= rows.begin && rowEnd - 1 < rows.end)
+		sim->_writeUVRow(rowEnd - 1);
+}
+
+void RippleSimulation::_writeUVRow(int row)
+{
+	if (m_precision == ERP_INT16)
+		this->_writeUVRow(static_cast<const s16*>(m_uvHeights), row);
+	else
+		this->_writeUVRow(static_cast<const int*>(m_uvHeights), row);
+}
+
+//one offset in the vertex format, the s8 one holds half the differences
+static inline void encodeUVOffset(int xoff, int yoff, float* uv)
+{
+	uv[0] = float(xoff);
+	uv[1] = float(yoff);
+}
+
+static inline void encodeUVOffset(int xoff, int yoff, s16* uv)
+{
+	uv[0] = s16(std::min(std::max(xoff, -32767), 32767));
+	uv[1] = s16(std::min(std::max(yoff, -32767), 32767));
+}
+
+static inline void encodeUVOffset(int xoff, int yoff, s8* uv)
+{
+	//halved, rounding away from zero
+	xoff = (xoff + (xoff > 0)) >> 1;
+	yoff = (yoff + (yoff > 0)) >> 1;
+	uv[0] = s8(std::min(std::max(xoff, -127), 127));
+	uv[1] = s8(std::min(std::max(yoff, -127), 127));
+}
+
+template<typename T, typename O>
+static void writeUVOffsetRow(const T* heights, int width, int height, int j, O* uvRow)
+{
+	const T* row = heights + j*width;
+	bool inside = j > 0 && j < height - 1;
+	for (int i=0; i<width; i++)
+	{
+		//one equals half a pixel, the border cells only move along the border
+		int xoff = (i > 0 && i < width - 1) ? row[i + 1] - row[i - 1] : 0;
+		int yoff = inside ? row[i + width] - row[i - width] : 0;
+		encodeUVOffset(xoff, yoff, uvRow + 2*i);
+	}
+}
+
+template<typename T>
+void RippleSimulation::_writeUVRow(const T* heights, int j)
+{
+	const int rowSize = m_width*getUVFormatSize(m_uvFormat);
+	u8* uvRow = m_pUVBufferWrite + (j - m_uvRows.begin)*rowSize;
+
+	//rows away from the waves keep their base coordinates
+	if (j < m_uvSourceRows.begin || j >= m_uvSourceRows.end)
+	{
+		memset(uvRow, 0, rowSize);
+		return;
+	}
+
+	switch (m_uvFormat)
+	{
+	case EUF_INT16:
+		writeUVOffsetRow(heights, m_width, m_height, j, reinterpret_cast<s16*>(uvRow));
+		break;
+	case EUF_INT8:
+		writeUVOffsetRow(heights, m_width, m_height, j, reinterpret_cast<s8*>(uvRow));
+		break;
+	default:
+		writeUVOffsetRow(heights, m_width, m_height, j, reinterpret_cast<float*>(uvRow));
+		break;
+	}
+}
+
+static const int m_Drip_Radius = 12;
+void RippleSimulation::Drop(int x, int y, int depth)
+{
+	this->Drop(x, y, m_dropStamps.GetRadial(m_Drip_Radius, depth));
+}
+
+void RippleSimulation::Drop(int x, int y, const DropStamp* stamp)
+{
+	//keep off the two border cells the stencil never steps, a drop there would
+	//keep its tile awake forever
+	int x0 = std::max(2, x + stamp->GetLeft());
+	int x1 = std::min(m_width - 2, x + stamp->GetLeft() + stamp->GetWidth());
+	int y0 = std::max(2, y + stamp->GetTop());
+	int y1 = std::min(m_height - 2, y + stamp->GetTop() + stamp->GetHeight());
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	this->_activateTiles(x0, y0, x1, y1);
+
+	if (m_precision == ERP_INT16)
+		stamp->Write(static_cast<s16*>(m_pHightWrite), m_width, x, y, x0, y0, x1, y1);
+	else
+		stamp->Write(static_cast<int*>(m_pHightWrite), m_width, x, y, x0, y0, x1, y1);
+}
+
+void RippleSimulation::DropSegment(int fromX, int fromY, int toX, int toY, int depth)
+{
+	int x0 = std::max(2, std::min(fromX, toX) - m_Drip_Radius);
+	int x1 = std::min(m_width - 2, std::max(fromX, toX) + m_Drip_Radius);
+	int y0 = std::max(2, std::min(fromY, toY) - m_Drip_Radius);
+	int y1 = std::min(m_height - 2, std::max(fromY, toY) + m_Drip_Radius);
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	this->_activateTiles(x0, y0, x1, y1);
+
+	if (m_precision == ERP_INT16)
+		this->_dropSegmentRows(static_cast<s16*>(m_pHightWrite), fromX, fromY, toX, toY, depth, x0, y0, x1, y1);
+	else
+		this->_dropSegmentRows(static_cast<int*>(m_pHightWrite), fromX, fromY, toX, toY, depth, x0, y0, x1, y1);
+}
+
+//narrows [begin, end] to the x with lower < k*x < upper
+static bool clipLinearSpan(float k, float lower, float upper, float& begin, float& end)
+{
+	if (k == 0.0f)
+		return lower < 0.0f && 0.0f < upper;
+
+	float a = lower/k;
+	float b = upper/k;
+	begin = std::max(begin, std::min(a, b));
+	end = std::min(end, std::max(a, b));
+	return begin <= end;
+}
+
+//widens [begin, end] by the chord of a circle of radius at centerX, dy rows away
+static void addCircleSpan(float centerX, float dy, float radius, float& begin, float& end)
+{
+	if (fabsf(dy) >= radius)
+		return;
+
+	float halfChord = sqrtf(radius*radius - dy*dy);
+	begin = std::min(begin, centerX - halfChord);
+	end = std::max(end, centerX + halfChord);
+}
+
+template<typename T>
+void RippleSimulation::_dropSegmentRows(T* heights, int fromX, int fromY, int toX, int toY, int depth,
+	int x0, int y0, int x1, int y1)
+{
+	//everything relative to from, with the same fall-off as the radial drop
+	const float radius = (float)m_Drip_Radius;
+	float dx = float(toX - fromX);
+	float dy = float(toY - fromY);
+	float lengthSqr = dx*dx + dy*dy;
+	float length = sqrtf(lengthSqr);
+
+	for (int j=y0; j<y1; ++j)
+	{
+		float py = float(j - fromY);
+
+		//the capsule is convex, so a row crosses it in one span: the chords of
+		//both end circles joined with the part of the band between them
+		float spanBegin = FLT_MAX;
+		float spanEnd = -FLT_MAX;
+		addCircleSpan(0.0f, py, radius, spanBegin, spanEnd);
+		addCircleSpan(dx, py - dy, radius, spanBegin, spanEnd);
+
+		float bandBegin = -FLT_MAX;
+		float bandEnd = FLT_MAX;
+		if (lengthSqr > 0.0f
+			&& clipLinearSpan(dy, py*dx - radius*length, py*dx + radius*length, bandBegin, bandEnd)
+			&& clipLinearSpan(dx, -py*dy, lengthSqr - py*dy, bandBegin, bandEnd))
+		{
+			spanBegin = std::min(spanBegin, bandBegin);
+			spanEnd = std::max(spanEnd, bandEnd);
+		}
+		if (spanBegin > spanEnd)
+			continue;
+
+		int i0 = std::max(x0, fromX + (int)floorf(spanBegin));
+		int i1 = std::min(x1, fromX + (int)ceilf(spanEnd) + 1);
+		T* row = heights + j*m_width;
+		for (int i=i0; i<i1; ++i)
+		{
+			float px = float(i - fromX);
+			float t = lengthSqr > 0.0f ? (px*dx + py*dy)/lengthSqr : 1.0f;
+			if (t <= 0.0f && lengthSqr > 0.0f)
+				continue;
+
+			t = std::min(t, 1.0f);
+			float ex = px - t*dx;
+			float ey = py - t*dy;
+			float distSqr = ex*ex + ey*ey;
+			if (distSqr >= radius*radius)
+				continue;
+
+			int finaldepth = (int)((float)depth * ((radius - sqrtf(distSqr))/radius));
+			finaldepth = std::min(std::max(finaldepth, -127), 127);
+			row[i] = (T)finaldepth;
+		}
+	}
+}
+
+void RippleSimulation::_activateTiles(int x0, int y0, int x1, int y1)
+{
+	for (int ty=y0/RIPPLE_TILE_SIZE; ty<=(y1 - 1)/RIPPLE_TILE_SIZE; ++ty)
+	{
+		for (int tx=x0/RIPPLE_TILE_SIZE; tx<=(x1 - 1)/RIPPLE_TILE_SIZE; ++tx)
+		{
+			u8& active = m_tileActive[ty*m_tilesX + tx];
+			if (!active)
+			{
+				active = 1;
+				++m_activeTileCount;
+			}
+		}
+	}
+
+	m_activeRows = m_activeRows.merged(RowRange(std::max(0, y0 - 1), std::min(m_height, y1 + 1)));
+}
+
+static int readHeight(const void* heights, E_Ripple_Precision precision, int index)
+{
+	if (precision == ERP_INT16)
+		return static_cast<const s16*>(heights)[index];
+	return static_cast<const int*>(heights)[index];
+}
+
+void RippleSimulation::Resample(const RippleSimulation& source)
+{
+	//the uv offset is the height difference of neighbour cells, scaling the
+	//heights with the grid keeps the slopes and so the refraction on screen
+	float scale = 0.5f*(float(m_width)/source.m_width + float(m_height)/source.m_height);
+	float stepX = float(source.m_width - 1)/(m_width - 1);
+	float stepY = float(source.m_height - 1)/(m_height - 1);
+
+	//both buffers, the previous heights carry the velocity of the waves
+	const void* sourceBuffers[2] = {source.m_pHightRead, source.m_pHightWrite};
+	void* buffers[2] = {m_pHightRead, m_pHightWrite};
+
+	std::fill(m_tileActive.begin(), m_tileActive.end(), 0);
+	for (int b=0; b<2; ++b)
+	{
+		//the borders stay flat like in Step()
+		for (int y=2; y<m_height - 2; ++y)
+		{
+			float sy = y*stepY;
+			int y0 = std::min(int(sy), source.m_height - 2);
+			float fy = sy - y0;
+
+			for (int x=2; x<m_width - 2; ++x)
+			{
+				float sx = x*stepX;
+				int x0 = std::min(int(sx), source.m_width - 2);
+				float fx = sx - x0;
+
+				int index = y0*source.m_width + x0;
+				float top = readHeight(sourceBuffers[b], source.m_precision, index)*(1.0f - fx)
+					+ readHeight(sourceBuffers[b], source.m_precision, index + 1)*fx;
+				float bottom = readHeight(sourceBuffers[b], source.m_precision, index + source.m_width)*(1.0f - fx)
+					+ readHeight(sourceBuffers[b], source.m_precision, index + source.m_width + 1)*fx;
+
+				float value = (top*(1.0f - fy) + bottom*fy)*scale;
+				int height = int(value < 0.0f ? value - 0.5f : value + 0.5f);
+				if (m_precision == ERP_INT16)
+				{
+					height = std::min(std::max(height, RIPPLE_HEIGHT16_MIN), RIPPLE_HEIGHT16_MAX);
+					static_cast<s16*>(buffers[b])[y*m_width + x] = s16(height);
+				}
+				else
+				{
+					static_cast<int*>(buffers[b])[y*m_width + x] = height;
+				}
+
+				if (height != 0)
+					m_tileActive[(y/RIPPLE_TILE_SIZE)*m_tilesX + x/RIPPLE_TILE_SIZE] = 1;
+			}
+		}
+	}
+
+	this->_countActiveTiles();
+}
+
+bool RippleSimulation::VerifyPrecision(E_Ripple_Precision precision, int width, int height, int steps)
+{
+	RippleSimulation reference(width, height, 1, ERP_INT32);
+	RippleSimulation simulation(width, height, 1, precision);
+
+	//a few overlapping drops, then let them ring out. They stay far below the
+	//s16 limits, rain would saturate the s16 field and the int one would not
+	for (int step=0; step<steps; ++step)
+	{
+		if (step%16 == 0 && step < steps/2)
+		{
+			int x = width/4 + (step*7)%(width/2);
+			int y = height/4 + (step*13)%(height/2);
+			int depth = (step%32 == 0) ? 64 : -64;
+			reference.Drop(x, y, depth);
+			simulation.Drop(x, y, depth);
+		}
+
+		reference.Step();
+		simulation.Step();
+
+		double expected = reference.GetEnergy();
+		double energy = simulation.GetEnergy();
+		if (fabs(energy - expected) > expected*1e-3)
+			return false;
+	}
+	return true;
+}
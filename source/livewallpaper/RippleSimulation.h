@@ -0,0 +1,264 @@
+#pragma once
+#include <vector>
+#include <core/types.h>
+#include "RippleKernel.h"
+#include "DropStamp.h"
+
+class WorkerPool;
+
+//! Half open range of grid rows.
+struct RowRange
+{
+	RowRange():begin(0),end(0){}
+	RowRange(int b, int e):begin(b),end(e){}
+
+	bool isEmpty() const
+	{
+		return end <= begin;
+	}
+
+	int getCount() const
+	{
+		return isEmpty() ? 0 : end - begin;
+	}
+
+	RowRange merged(const RowRange& other) const
+	{
+		if (isEmpty())
+			return other;
+		if (other.isEmpty())
+			return *this;
+		return RowRange(begin < other.begin ? begin : other.begin, end > other.end ? end : other.end);
+	}
+
+	int begin;
+	int end;
+};
+
+//! Vertex format of the coordinate offsets the uv pass writes. An offset is
+//! the pair of height differences across a cell, the vertex shader adds it
+//! to the base coordinate it derives from the grid position.
+enum E_UV_Format
+{
+	//float pair, the differences as they are
+	EUF_FLOAT = 0,
+
+	//normalized s16 pair, lossless unless a difference leaves the s16 range
+	EUF_INT16,
+
+	//normalized s8 pair of the halved differences, steps of one texel of a
+	//512 texture and at most 127 of them
+	EUF_INT8,
+
+	EUF_COUNT,
+};
+
+const char* getUVFormatName(E_UV_Format format);
+
+//! Bytes per vertex.
+int getUVFormatSize(E_UV_Format format);
+
+//! Texture coordinate distance of an offset of 1.0 as the shader reads it,
+//! after normalization.
+float getUVOffsetScale(E_UV_Format format);
+
+//! CPU height field solver behind the UV water mesh.
+//!
+//! Owns the height buffers and turns them into the texture coordinate
+//! offsets they displace the water by, and knows nothing about GL. Step() and WriteUV() split the grid into row
+//! bands that run on a worker pool: the stencil pass reads two halo rows above
+//! and below each band, the UV pass reads one.
+//!
+//! Step(uvRows, rows) fuses both passes, each band writes the coordinates of
+//! a row as soon as the heights of the row below it are done, so the new
+//! heights are still in cache when they are read again.
+//!
+//! The grid is also cut into square tiles that are only simulated while they,
+//! or a neighbour, hold a non-zero height. Once the waves have died out a step
+//! does no work at all.
+class RippleSimulation
+{
+public:
+	//! threadCount 0 uses one thread per processor.
+	RippleSimulation(int width, int height, int threadCount = 0, E_Ripple_Precision precision = ERP_INT32,
+		E_UV_Format uvFormat = EUF_FLOAT);
+	~RippleSimulation();
+
+	//! Advances the height field one tick. Returns the rows whose offsets may
+	//! be non-zero, everything outside is at rest.
+	RowRange Step();
+
+	//! Step() and WriteUV() in one sweep, uvRows points at the first of rows
+	//! and receives the offsets of the new heights.
+	RowRange Step(void* uvRows, const RowRange& rows);
+
+	//! Rows whose offsets the next Step() may change, including the ones that
+	//! come to rest.
+	RowRange GetStepRows() const;
+
+	//! Writes offsets in GetUVFormat() for the given rows, uvRows points at
+	//! the first of them. Rows at rest get zeros.
+	void WriteUV(void* uvRows, const RowRange& rows);
+
+	//! The radial touch drop, its stamp is cached per depth.
+	void Drop(int x, int y, int depth);
+	void Drop(int x, int y, const DropStamp* stamp);
+
+	//! One piece of a drag, the radial drop swept from one sample to the next
+	//! as a capsule and written once, row span by row span. The round cap at
+	//! from is left out, the drop or segment before already wrote it.
+	void DropSegment(int fromX, int fromY, int toX, int toY, int depth);
+
+	int GetWidth() const;
+	int GetHeight() const;
+	int GetThreadCount() const;
+	int GetTileCount() const;
+	int GetActiveTileCount() const;
+	E_Ripple_Kernel GetKernel() const;
+	E_Ripple_Precision GetPrecision() const;
+	E_UV_Format GetUVFormat() const;
+
+	//! Rows that are not at rest after the last Step() or Drop().
+	RowRange GetActiveRows() const;
+
+	//! Current heights, int or s16 depending on GetPrecision().
+	const void* GetHeightBuffer() const;
+	int GetHeightAt(int x, int y) const;
+
+	//! Takes over the waves of another simulation, bilinearly resampled to
+	//! this grid, so a change of resolution carries on where it left off.
+	void Resample(const RippleSimulation& source);
+
+	//! Sum of the squared heights.
+	double GetEnergy() const;
+
+	//! FNV-1a over the current heights as 32 bit values, equal for both
+	//! precisions when the heights are.
+	u64 GetHeightChecksum() const;
+
+	//! Runs a scripted sequence of drops on precision and on ERP_INT32 and
+	//! compares the wave energy after every step. The drops stay inside the
+	//! s16 range, past it the precisions differ by design. Takes a while, the
+	//! benchmark runs it rather than the wallpaper.
+	static bool VerifyPrecision(E_Ripple_Precision precision, int width, int height, int steps);
+
+private:
+	static void _stencilBand(void* context, int band);
+	static void _uvBand(void* context, int band);
+	static void _uvEdgeBand(void* context, int band);
+
+	template<typename T> void _stencilRows(int band);
+	template<typename T> void _writeUVRow(const T* heights, int row);
+	void _writeUVRow(int row);
+
+	void _rippleRow(const int* heightRead, int* heightWrite, int count) const;
+	void _rippleRow(const s16* heightRead, s16* heightWrite, int count) const;
+
+	void _getBandRows(int band, int& rowBegin, int& rowEnd) const;
+	void _activateTiles(int x0, int y0, int x1, int y1);
+	//! m_activeTileCount and m_activeRows from m_tileActive
+	void _countActiveTiles();
+	template<typename T> void _dropSegmentRows(T* heights, int fromX, int fromY, int toX, int toY, int depth,
+		int x0, int y0, int x1, int y1);
+
+private:
+	int					m_width;
+	int					m_height;
+	int					m_bandCount;
+	int					m_bandRows;
+
+	//int or s16 cells
+	void*				m_pHightRead;
+	void*				m_pHightWrite;
+
+	//rows written by the current uv pass from m_uvHeights, rows outside
+	//m_uvSourceRows are cleared
+	u8*					m_pUVBufferWrite;
+	RowRange			m_uvRows;
+	RowRange			m_uvSourceRows;
+	const void*			m_uvHeights;
+	RowRange			m_activeRows;
+
+	//tiles holding non-zero heights, and the ones the current step touches
+	int					m_tilesX;
+	int					m_tilesY;
+	std::vector<u8>		m_tileActive;
+	std::vector<u8>		m_tileSimulate;
+	int					m_activeTileCount;
+
+	E_Ripple_Precision	m_precision;
+	E_UV_Format			m_uvFormat;
+	E_Ripple_Kernel		m_kernel;
+	RippleRowFunc		m_rippleRow;
+	RippleRowFunc16		m_rippleRow16;
+
+	DropStampCache		m_dropStamps;
+
+	WorkerPool*			m_workerPool;
+};
+
+inline int
+RippleSimulation::GetWidth() const
+{
+	return m_width;
+}
+
+inline int
+RippleSimulation::GetHeight() const
+{
+	return m_height;
+}
+
+inline int
+RippleSimulation::GetTileCount() const
+{
+	return m_tilesX*m_tilesY;
+}
+
+inline int
+RippleSimulation::GetActiveTileCount() const
+{
+	return m_activeTileCount;
+}
+
+inline RowRange
+RippleSimulation::GetActiveRows() const
+{
+	return m_activeRows;
+}
+
+inline E_Ripple_Kernel
+RippleSimulation::GetKernel() const
+{
+	return m_kernel;
+}
+
+inline void
+RippleSimulation::_rippleRow(const int* heightRead, int* heightWrite, int count) const
+{
+	m_rippleRow(heightRead, heightWrite, count, m_width);
+}
+
+inline void
+RippleSimulation::_rippleRow(const s16* heightRead, s16* heightWrite, int count) const
+{
+	m_rippleRow16(heightRead, heightWrite, count, m_width);
+}
+
+inline E_Ripple_Precision
+RippleSimulation::GetPrecision() const
+{
+	return m_precision;
+}
+
+inline E_UV_Format
+RippleSimulation::GetUVFormat() const
+{
+	return m_uvFormat;
+}
+
+inline const void*
+RippleSimulation::GetHeightBuffer() const
+{
+	return m_pHightRead;
+}
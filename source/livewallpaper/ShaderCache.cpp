@@ -0,0 +1,162 @@
+#include "ShaderCache.h"
+#include <stdio.h>
+#include <vector>
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+//"LWPB", then the layout version of the header
+static const u32 SHADER_CACHE_MAGIC = 0x4250574c;
+static const u32 SHADER_CACHE_VERSION = 1;
+
+struct ShaderCacheHeader
+{
+	u32		magic;
+	u32		version;
+	u32		binaryFormat;
+	u32		length;
+};
+
+//FNV-1a, a string and its terminator, so "ab","c" and "a","bc" differ
+static u64 hashString(u64 hash, const char* str)
+{
+	if (str)
+	{
+		for (; *str; ++str)
+			hash = (hash ^ u8(*str))*1099511628211ULL;
+	}
+	return hash*1099511628211ULL;
+}
+
+bool ShaderCache::IsSupported()
+{
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	return formatCount > 0;
+}
+
+ShaderCache::ShaderCache():m_driverHash(14695981039346656037ULL)
+	,m_hitCount(0)
+	,m_missCount(0)
+{
+	m_driverHash = hashString(m_driverHash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+	m_driverHash = hashString(m_driverHash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	m_driverHash = hashString(m_driverHash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+}
+
+ShaderCache::~ShaderCache()
+{
+}
+
+void ShaderCache::SetDirectory(const char* directory)
+{
+	m_directory = directory ? directory : "";
+	if (!m_directory.empty() && m_directory[m_directory.size() - 1] != '/' && m_directory[m_directory.size() - 1] != '\\')
+		m_directory += '/';
+}
+
+u64 ShaderCache::GetKey(const char* vertexSource, const char* fragmentSource) const
+{
+	return hashString(hashString(m_driverHash, vertexSource), fragmentSource);
+}
+
+std::string ShaderCache::_getPath(u64 key) const
+{
+	char name[32];
+	sprintf(name, "%016llx.bin", (unsigned long long)key);
+	return m_directory + name;
+}
+
+//rename() on windows fails when the target exists, another process may have
+//stored the same entry in the meantime
+static bool replaceFile(const char* from, const char* to)
+{
+#if defined(_WIN32)
+	return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(from, to) == 0;
+#endif
+}
+
+bool ShaderCache::Load(u64 key, GLuint program)
+{
+	FILE* file = fopen(this->_getPath(key).c_str(), "rb");
+	if (!file)
+	{
+		++m_missCount;
+		return false;
+	}
+
+	long fileSize = 0;
+	if (fseek(file, 0, SEEK_END) == 0)
+		fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	//a damaged length must not allocate more than the file holds
+	ShaderCacheHeader header;
+	std::vector<u8> binary;
+	bool valid = fileSize >= long(sizeof(header))
+		&& fread(&header, sizeof(header), 1, file) == 1
+		&& header.magic == SHADER_CACHE_MAGIC && header.version == SHADER_CACHE_VERSION && header.length > 0
+		&& header.length <= u32(fileSize - long(sizeof(header)));
+	if (valid)
+	{
+		binary.resize(header.length);
+		valid = fread(&binary[0], 1, header.length, file) == header.length;
+	}
+	fclose(file);
+
+	GLint linked = 0;
+	if (valid)
+	{
+		glProgramBinary(program, header.binaryFormat, &binary[0], header.length);
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	}
+
+	if (!linked)
+	{
+		//truncated, or from a driver that reports the same strings
+		++m_missCount;
+		return false;
+	}
+	++m_hitCount;
+	return true;
+}
+
+bool ShaderCache::Store(u64 key, GLuint program)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return false;
+
+	std::vector<u8> binary(length);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(program, length, &length, &binaryFormat, &binary[0]);
+	if (length <= 0)
+		return false;
+
+	ShaderCacheHeader header;
+	header.magic = SHADER_CACHE_MAGIC;
+	header.version = SHADER_CACHE_VERSION;
+	header.binaryFormat = binaryFormat;
+	header.length = u32(length);
+
+	//written aside and moved in place, a crash never leaves half an entry
+	std::string path = this->_getPath(key);
+	std::string writePath = path + ".tmp";
+	FILE* file = fopen(writePath.c_str(), "wb");
+	if (!file)
+		return false;
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(&binary[0], 1, header.length, file) == header.length;
+	written = (fclose(file) == 0) && written;
+
+	if (!written || !replaceFile(writePath.c_str(), path.c_str()))
+	{
+		remove(writePath.c_str());
+		return false;
+	}
+	return true;
+}
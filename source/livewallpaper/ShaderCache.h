@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <GLES3/gl3.h>
+#include <core/types.h>
+#include <core/singleton.h>
+
+//! Linked programs kept on disk as glGetProgramBinary blobs, so later starts
+//! skip compiling them.
+//!
+//! Entries are keyed by a hash of the shader sources and the vendor, renderer
+//! and version strings of the driver. A driver update changes the key, its
+//! old entries are never read again. A blob the driver rejects anyway counts
+//! as a miss and the program is compiled from source.
+class ShaderCache:public Singleton<ShaderCache>
+{
+	friend class Singleton<ShaderCache>;
+
+public:
+	//! Needs a current context with at least one program binary format.
+	static bool IsSupported();
+
+	//! Directory the entries go in, it must exist.
+	void SetDirectory(const char* directory);
+
+	//! Key of the program of these sources on the current driver.
+	u64 GetKey(const char* vertexSource, const char* fragmentSource) const;
+
+	//! Links program from the entry of key, false when there is none or the
+	//! driver rejects it.
+	bool Load(u64 key, GLuint program);
+
+	//! Writes the binary of a linked program under key.
+	bool Store(u64 key, GLuint program);
+
+	int GetHitCount() const;
+	int GetMissCount() const;
+
+protected:
+	ShaderCache();
+	~ShaderCache();
+
+private:
+	std::string		_getPath(u64 key) const;
+
+	std::string		m_directory;
+	//hash of the driver strings, the seed of every key
+	u64				m_driverHash;
+	int				m_hitCount;
+	int				m_missCount;
+};
+
+inline int
+ShaderCache::GetHitCount() const
+{
+	return m_hitCount;
+}
+
+inline int
+ShaderCache::GetMissCount() const
+{
+	return m_missCount;
+}
@@ -0,0 +1,130 @@
+#include "StreamingBuffer.h"
+#include "esutils.h"
+
+StreamingBuffer::StreamingBuffer(GLenum target, GLsizeiptr segmentSize, int segmentCount)
+	:m_target(target)
+	,m_buffer(0)
+	,m_segmentSize(segmentSize)
+	,m_segmentCount(segmentCount > 0 ? segmentCount : 1)
+	,m_current(0)
+	,m_useMapping(esGetContextMajorVersion() >= 3)
+	,m_mapped(false)
+	,m_mapOffset(0)
+	,m_mapLength(0)
+	,m_fences(nullptr)
+	,m_staging(nullptr)
+{
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(m_target, m_buffer);
+
+	if (m_useMapping)
+	{
+		glBufferData(m_target, m_segmentSize*m_segmentCount, NULL, GL_STREAM_DRAW);
+
+		m_fences = new GLsync[m_segmentCount];
+		for (int i=0; i<m_segmentCount; ++i)
+			m_fences[i] = 0;
+
+		//first Map() moves to segment 0
+		m_current = m_segmentCount - 1;
+	}
+	else
+	{
+		glBufferData(m_target, m_segmentSize, NULL, GL_DYNAMIC_DRAW);
+		m_staging = new unsigned char[m_segmentSize];
+	}
+
+	glBindBuffer(m_target, 0);
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+	if (m_fences)
+	{
+		for (int i=0; i<m_segmentCount; ++i)
+		{
+			if (m_fences[i])
+				glDeleteSync(m_fences[i]);
+		}
+		delete[] m_fences;
+	}
+
+	delete[] m_staging;
+	glDeleteBuffers(1, &m_buffer);
+}
+
+void* StreamingBuffer::Map()
+{
+	return this->Map(0, m_segmentSize);
+}
+
+void* StreamingBuffer::Map(GLintptr offset, GLsizeiptr length)
+{
+	m_mapOffset = offset;
+	m_mapLength = length;
+
+	if (!m_useMapping)
+	{
+		m_mapped = true;
+		return m_staging + offset;
+	}
+
+	int next = this->GetNextSegment();
+
+	//with enough segments the gpu is long done with this one and the wait is free
+	GLsync& fence = m_fences[next];
+	if (fence)
+	{
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fence);
+		fence = 0;
+	}
+
+	glBindBuffer(m_target, m_buffer);
+	void* data = glMapBufferRange(m_target, next*m_segmentSize + offset, length,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	glBindBuffer(m_target, 0);
+
+	//a failed map leaves the segment drawn last current, its contents are intact
+	m_mapped = (data != NULL);
+	if (m_mapped)
+		m_current = next;
+	return data;
+}
+
+GLintptr StreamingBuffer::Unmap()
+{
+	if (!m_mapped)
+		return GetOffset();
+
+	glBindBuffer(m_target, m_buffer);
+	if (m_useMapping)
+	{
+		glUnmapBuffer(m_target);
+	}
+	else if (m_mapLength == m_segmentSize)
+	{
+		//orphan the old storage instead of waiting for draws still reading it
+		glBufferData(m_target, m_segmentSize, NULL, GL_DYNAMIC_DRAW);
+		glBufferSubData(m_target, 0, m_segmentSize, m_staging);
+	}
+	else
+	{
+		glBufferSubData(m_target, m_mapOffset, m_mapLength, m_staging + m_mapOffset);
+	}
+	glBindBuffer(m_target, 0);
+
+	m_mapped = false;
+	return GetOffset();
+}
+
+void StreamingBuffer::Fence()
+{
+	if (!m_useMapping)
+		return;
+
+	GLsync& fence = m_fences[m_current];
+	if (fence)
+		glDeleteSync(fence);
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <GLES3/gl3.h>
+
+//! Vertex buffer for data that is rewritten every frame.
+//!
+//! The GL buffer is split into a ring of segments. Map() hands out the next
+//! segment through an unsynchronized glMapBufferRange once the fence placed
+//! after its last draw has passed, so the driver never reallocates or waits
+//! and the caller can write straight into buffer memory. Contexts without
+//! glMapBufferRange fall back to a CPU staging copy and an orphaning
+//! glBufferData upload, or a glBufferSubData of the mapped range when only
+//! part of the segment is mapped.
+class StreamingBuffer
+{
+public:
+	StreamingBuffer(GLenum target, GLsizeiptr segmentSize, int segmentCount);
+	~StreamingBuffer();
+
+	//! Returns writable memory for one segment, NULL when mapping fails and
+	//! the segment drawn last stays current.
+	void*		Map();
+
+	//! Moves to the next segment like Map() but only maps length bytes at
+	//! offset into it, the rest of the segment keeps its old content.
+	void*		Map(GLintptr offset, GLsizeiptr length);
+
+	//! Finishes the write, returns the byte offset of the segment in the buffer.
+	GLintptr	Unmap();
+
+	//! Call after the last draw that reads the current segment.
+	void		Fence();
+
+	GLuint		GetBuffer() const;
+	GLintptr	GetOffset() const;
+	GLsizeiptr	GetSegmentSize() const;
+	bool		IsMapped() const;
+
+	//! Segment handed out by the last and by the next Map().
+	int			GetSegment() const;
+	int			GetNextSegment() const;
+
+private:
+	GLenum			m_target;
+	GLuint			m_buffer;
+	GLsizeiptr		m_segmentSize;
+	int				m_segmentCount;
+	int				m_current;
+	bool			m_useMapping;
+	bool			m_mapped;
+	GLintptr		m_mapOffset;
+	GLsizeiptr		m_mapLength;
+
+	GLsync*			m_fences;
+	unsigned char*	m_staging;
+};
+
+inline GLuint
+StreamingBuffer::GetBuffer() const
+{
+	return m_buffer;
+}
+
+inline GLintptr
+StreamingBuffer::GetOffset() const
+{
+	return m_useMapping ? m_current*m_segmentSize : 0;
+}
+
+inline GLsizeiptr
+StreamingBuffer::GetSegmentSize() const
+{
+	return m_segmentSize;
+}
+
+inline bool
+StreamingBuffer::IsMapped() const
+{
+	return m_mapped;
+}
+
+inline int
+StreamingBuffer::GetSegment() const
+{
+	return m_useMapping ? m_current : 0;
+}
+
+inline int
+StreamingBuffer::GetNextSegment() const
+{
+	return m_useMapping ? (m_current + 1)%m_segmentCount : 0;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <core/types.h>
+
+enum E_Touch_Phase
+{
+	//finger down or moved, continues the open stroke
+	ETP_MOVE = 0,
+
+	//finger lifted, ends the stroke, the position is unused
+	ETP_UP,
+};
+
+//! One touch sample in screen pixels, Time in getTimeMicroseconds() time.
+struct TouchEvent
+{
+	TouchEvent():X(0),Y(0),Time(0),Phase(ETP_MOVE){}
+	TouchEvent(int x, int y, u64 time, E_Touch_Phase phase = ETP_MOVE):X(x),Y(y),Time(time),Phase(phase){}
+	int X;
+	int Y;
+	u64 Time;
+	E_Touch_Phase Phase;
+};
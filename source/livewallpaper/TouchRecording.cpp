@@ -0,0 +1,140 @@
+#include "TouchRecording.h"
+#include <stdio.h>
+#include <string.h>
+
+//header: magic, version, screen width, screen height, touch count as u32
+static const char RECORDING_MAGIC[4] = {'L', 'W', 'T', 'R'};
+static const u32 RECORDING_VERSION = 1;
+
+//per touch: u32 frame, u32 microseconds after the first touch, s16 x, s16 y,
+//u8 phase
+static const int RECORD_SIZE = 13;
+
+static void writeU32(u8* data, u32 value)
+{
+	data[0] = u8(value);
+	data[1] = u8(value >> 8);
+	data[2] = u8(value >> 16);
+	data[3] = u8(value >> 24);
+}
+
+static u32 readU32(const u8* data)
+{
+	return u32(data[0]) | (u32(data[1]) << 8) | (u32(data[2]) << 16) | (u32(data[3]) << 24);
+}
+
+static void writeS16(u8* data, int value)
+{
+	data[0] = u8(value);
+	data[1] = u8(value >> 8);
+}
+
+static int readS16(const u8* data)
+{
+	return s16(u16(data[0]) | (u16(data[1]) << 8));
+}
+
+TouchRecording::TouchRecording():m_screenWidth(0)
+	,m_screenHeight(0)
+{
+}
+
+void TouchRecording::SetScreenSize(int width, int height)
+{
+	m_screenWidth = width;
+	m_screenHeight = height;
+}
+
+void TouchRecording::Add(u32 frame, const TouchEvent& touch)
+{
+	Entry entry;
+	entry.frame = frame;
+	entry.touch = touch;
+	m_entries.push_back(entry);
+}
+
+void TouchRecording::Clear()
+{
+	m_entries.clear();
+}
+
+bool TouchRecording::Save(const char* path) const
+{
+	FILE* file = fopen(path, "wb");
+	if (!file)
+		return false;
+
+	u8 header[20];
+	memcpy(header, RECORDING_MAGIC, 4);
+	writeU32(header + 4, RECORDING_VERSION);
+	writeU32(header + 8, u32(m_screenWidth));
+	writeU32(header + 12, u32(m_screenHeight));
+	writeU32(header + 16, u32(m_entries.size()));
+	bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+
+	u64 origin = m_entries.empty() ? 0 : m_entries[0].touch.Time;
+	for (size_t i=0; i<m_entries.size() && ok; ++i)
+	{
+		const Entry& entry = m_entries[i];
+
+		u8 record[RECORD_SIZE];
+		writeU32(record, entry.frame);
+		writeU32(record + 4, u32(entry.touch.Time - origin));
+		writeS16(record + 8, entry.touch.X);
+		writeS16(record + 10, entry.touch.Y);
+		record[12] = u8(entry.touch.Phase);
+		ok = fwrite(record, RECORD_SIZE, 1, file) == 1;
+	}
+
+	fclose(file);
+	return ok;
+}
+
+bool TouchRecording::Load(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return false;
+
+	m_entries.clear();
+
+	//the records a file of this size can hold at most
+	long fileSize = 0;
+	if (fseek(file, 0, SEEK_END) == 0)
+		fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	u8 header[20];
+	bool ok = fileSize >= long(sizeof(header))
+		&& fread(header, sizeof(header), 1, file) == 1
+		&& memcmp(header, RECORDING_MAGIC, 4) == 0
+		&& readU32(header + 4) == RECORDING_VERSION;
+
+	u32 count = ok ? readU32(header + 16) : 0;
+	ok = ok && count <= u32((fileSize - long(sizeof(header)))/RECORD_SIZE);
+
+	if (ok)
+	{
+		m_screenWidth = int(readU32(header + 8));
+		m_screenHeight = int(readU32(header + 12));
+
+		m_entries.reserve(count);
+		for (u32 i=0; i<count && ok; ++i)
+		{
+			u8 record[RECORD_SIZE];
+			ok = fread(record, RECORD_SIZE, 1, file) == 1 && record[12] <= ETP_UP;
+			if (ok)
+			{
+				TouchEvent touch(readS16(record + 8), readS16(record + 10), readU32(record + 4), E_Touch_Phase(record[12]));
+				this->Add(readU32(record), touch);
+			}
+		}
+	}
+
+	fclose(file);
+
+	//no half recording from a truncated or damaged file
+	if (!ok)
+		m_entries.clear();
+	return ok;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <core/types.h>
+#include "TouchEvent.h"
+
+//! A touch stream with the frame each touch was applied in, for replaying
+//! the same input into a fresh LiveWallPaper.
+//!
+//! Saved as a small binary file: a header followed by one packed record per
+//! touch, little endian.
+class TouchRecording
+{
+public:
+	struct Entry
+	{
+		//frames after the recording started
+		u32				frame;
+		TouchEvent		touch;
+	};
+
+	TouchRecording();
+
+	//! Screen size the positions are in.
+	void SetScreenSize(int width, int height);
+	int GetScreenWidth() const;
+	int GetScreenHeight() const;
+
+	void Add(u32 frame, const TouchEvent& touch);
+	void Clear();
+
+	//! Times are stored relative to the first touch.
+	bool Save(const char* path) const;
+
+	//! Leaves the recording empty when the file is damaged.
+	bool Load(const char* path);
+
+	int GetCount() const;
+	const Entry& GetEntry(int index) const;
+
+	//! Frame after the last touch.
+	u32 GetFrameCount() const;
+
+private:
+	int					m_screenWidth;
+	int					m_screenHeight;
+	std::vector<Entry>	m_entries;
+};
+
+inline int
+TouchRecording::GetScreenWidth() const
+{
+	return m_screenWidth;
+}
+
+inline int
+TouchRecording::GetScreenHeight() const
+{
+	return m_screenHeight;
+}
+
+inline int
+TouchRecording::GetCount() const
+{
+	return int(m_entries.size());
+}
+
+inline const TouchRecording::Entry&
+TouchRecording::GetEntry(int index) const
+{
+	return m_entries[index];
+}
+
+inline u32
+TouchRecording::GetFrameCount() const
+{
+	return m_entries.empty() ? 0 : m_entries.back().frame + 1;
+}
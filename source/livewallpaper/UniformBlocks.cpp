@@ -0,0 +1,94 @@
+#include "UniformBlocks.h"
+#include "StreamingBuffer.h"
+#include <string.h>
+
+//enough segments for the cpu to run two frames ahead of the gpu
+static const int UNIFORM_BLOCK_SEGMENTS = 3;
+
+JENNY_STATIC_ASSERT(sizeof(FrameUniforms) == 96);
+JENNY_STATIC_ASSERT(sizeof(PassUniforms) == 16);
+
+const char* getUniformBlockName(E_Uniform_Block block)
+{
+	switch (block)
+	{
+	case EUB_FRAME:		return "FrameUniforms";
+	case EUB_PASS:		return "PassUniforms";
+	default:			return "unknown";
+	}
+}
+
+E_Uniform_Block getUniformBlock(const char* name)
+{
+	for (int i=0; i<EUB_COUNT; ++i)
+	{
+		if (strcmp(name, getUniformBlockName(E_Uniform_Block(i))) == 0)
+			return E_Uniform_Block(i);
+	}
+	return EUB_COUNT;
+}
+
+u32 getUniformBlockSize(E_Uniform_Block block)
+{
+	switch (block)
+	{
+	case EUB_FRAME:		return sizeof(FrameUniforms);
+	case EUB_PASS:		return sizeof(PassUniforms);
+	default:			return 0;
+	}
+}
+
+static GLsizeiptr alignUniformOffset(GLsizeiptr offset, GLint alignment)
+{
+	return (offset + alignment - 1)/alignment*alignment;
+}
+
+UniformBlocks::UniformBlocks(int passCount)
+	:m_buffer(nullptr)
+	,m_passCount(passCount > 0 ? passCount : 1)
+	,m_passStride(0)
+	,m_passOffset(0)
+	,m_segmentOffset(0)
+{
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment <= 0)
+		alignment = 256;
+
+	//segments are bound at their offset too, so their size is aligned as well
+	m_passOffset = alignUniformOffset(sizeof(FrameUniforms), alignment);
+	m_passStride = alignUniformOffset(sizeof(PassUniforms), alignment);
+	GLsizeiptr segmentSize = alignUniformOffset(m_passOffset + m_passStride*m_passCount, alignment);
+	m_buffer = new StreamingBuffer(GL_UNIFORM_BUFFER, segmentSize, UNIFORM_BLOCK_SEGMENTS);
+}
+
+UniformBlocks::~UniformBlocks()
+{
+	delete m_buffer;
+}
+
+void UniformBlocks::Update(const FrameUniforms& frame, const PassUniforms* passes)
+{
+	u8* data = reinterpret_cast<u8*>(m_buffer->Map());
+	if (data)
+	{
+		memcpy(data, &frame, sizeof(frame));
+		for (int i=0; i<m_passCount; ++i)
+			memcpy(data + m_passOffset + i*m_passStride, &passes[i], sizeof(PassUniforms));
+	}
+	m_segmentOffset = m_buffer->Unmap();
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, EUB_FRAME, m_buffer->GetBuffer(), m_segmentOffset, sizeof(FrameUniforms));
+}
+
+void UniformBlocks::BindPass(int pass) const
+{
+	JENNY_ASSERT(pass >= 0 && pass < m_passCount);
+	glBindBufferRange(GL_UNIFORM_BUFFER, EUB_PASS, m_buffer->GetBuffer(),
+		m_segmentOffset + m_passOffset + pass*m_passStride, sizeof(PassUniforms));
+}
+
+void UniformBlocks::Fence()
+{
+	m_buffer->Fence();
+}
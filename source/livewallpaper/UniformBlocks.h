@@ -0,0 +1,91 @@
+#pragma once
+#include <GLES3/gl3.h>
+#include <core/types.h>
+
+class StreamingBuffer;
+
+//! Uniform blocks shared by every program. The value is the binding point,
+//! Shader binds blocks of these names to it when it reflects a program.
+enum E_Uniform_Block
+{
+	EUB_FRAME=0,
+	EUB_PASS,
+	EUB_COUNT
+};
+
+//! Block name in GLSL.
+const char* getUniformBlockName(E_Uniform_Block block);
+
+//! EUB_COUNT for names that are not shared blocks.
+E_Uniform_Block getUniformBlock(const char* name);
+
+//! std140 layout of FrameUniforms, values that stay the same in every pass
+//! of a frame. In GLSL:
+//!
+//!	layout(std140) uniform FrameUniforms
+//!	{
+//!		highp mat4 viewProjection;
+//!		highp vec3 light;
+//!		highp vec2 screenSize;
+//!	};
+struct FrameUniforms
+{
+	f32		viewProjection[16];
+	//normalized direction the light shines in
+	f32		light[3];
+	f32		pad0;
+	f32		screenSize[2];
+	f32		pad1[2];
+};
+
+//! std140 layout of PassUniforms, values of the pass that draws. In GLSL:
+//!
+//!	layout(std140) uniform PassUniforms
+//!	{
+//!		highp vec2 delta;
+//!	};
+struct PassUniforms
+{
+	//texel size of the height texture the pass samples
+	f32		delta[2];
+	f32		pad0[2];
+};
+
+//! Size of the C++ struct of a block.
+u32 getUniformBlockSize(E_Uniform_Block block);
+
+//! Streams the frame block and one block per pass into a single uniform
+//! buffer, written with one upload per frame. Each pass then only binds its
+//! range instead of setting uniforms one by one. Needs an ES 3 context.
+class UniformBlocks
+{
+public:
+	explicit UniformBlocks(int passCount);
+	~UniformBlocks();
+
+	//! Uploads the blocks of a frame, passes has passCount entries, and binds
+	//! the frame block.
+	void	Update(const FrameUniforms& frame, const PassUniforms* passes);
+
+	//! Binds the block of a pass of the last Update().
+	void	BindPass(int pass) const;
+
+	//! Call after the last draw that reads the blocks of the frame.
+	void	Fence();
+
+	int		GetPassCount() const;
+
+private:
+	StreamingBuffer*	m_buffer;
+	int					m_passCount;
+	//pass blocks start at a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	GLsizeiptr			m_passStride;
+	GLintptr			m_passOffset;
+	GLintptr			m_segmentOffset;
+};
+
+inline int
+UniformBlocks::GetPassCount() const
+{
+	return m_passCount;
+}
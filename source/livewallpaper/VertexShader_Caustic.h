@@ -5,8 +5,12 @@ const float IOR_WATER = 1.333;																\n\
 																							\n\
 layout(location = 0) in vec3 position;														\n\
 																							\n\
-uniform vec3 light;																			\n\
-uniform vec2 screenSize;																	\n\
+layout(std140) uniform FrameUniforms														\n\
+{																							\n\
+	highp mat4 viewProjection;																\n\
+	highp vec3 light;																		\n\
+	highp vec2 screenSize;																	\n\
+};																							\n\
 uniform sampler2D water;																	\n\
 																							\n\
 out vec3 oldPos;																			\n\
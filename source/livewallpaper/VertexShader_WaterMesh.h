@@ -1,18 +1,23 @@
-"																							\n\
-attribute vec3 position;																	\n\
+"#version 300 es																			\n\
+																							\n\
+in vec3 position;																			\n\
 																							\n\
 uniform sampler2D water;																	\n\
-uniform highp mat4 WVPMatrix;																\n\
-uniform highp vec2 screenSize;																\n\
+layout(std140) uniform FrameUniforms														\n\
+{																							\n\
+	highp mat4 viewProjection;																\n\
+	highp vec3 light;																		\n\
+	highp vec2 screenSize;																	\n\
+};																							\n\
 																							\n\
-varying vec3 vPosition;																		\n\
-varying vec2 vCoord;																		\n\
+out vec3 vPosition;																			\n\
+out vec2 vCoord;																			\n\
 																							\n\
 void main()																					\n\
 {																							\n\
 	vCoord = position.xy;																	\n\
-	vec4 info = texture2D(water, position.xy);												\n\
+	vec4 info = texture(water, position.xy);												\n\
 	vPosition = vec3((position.x-0.5)*screenSize.x, (position.y-0.5)*screenSize.y, info.r);	\n\
-	gl_Position = WVPMatrix * vec4(vPosition, 1.0);											\n\
+	gl_Position = viewProjection * vec4(vPosition, 1.0);									\n\
 }																							\n\
 ";
\ No newline at end of file
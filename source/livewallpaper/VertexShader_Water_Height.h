@@ -0,0 +1,22 @@
+"																							\n\
+attribute vec2 position;																	\n\
+uniform sampler2D heights;																	\n\
+uniform vec2 gridSize;																		\n\
+varying vec2 vCoord;																		\n\
+																							\n\
+float height(vec2 cell)																		\n\
+{																							\n\
+	return texture2D(heights, (cell + 0.5)/gridSize).r;										\n\
+}																							\n\
+																							\n\
+void main()																					\n\
+{                                                                                           \n\
+	//same displacement as the cpu uv pass, one height unit is half a texel of 512			\n\
+	vec2 base = position*0.5 + 0.5;															\n\
+	vec2 cell = floor(base*(gridSize - 1.0) + 0.5);											\n\
+	float xoff = height(cell + vec2(1.0, 0.0)) - height(cell - vec2(1.0, 0.0));				\n\
+	float yoff = height(cell + vec2(0.0, 1.0)) - height(cell - vec2(0.0, 1.0));				\n\
+	vCoord = base + vec2(xoff, yoff)*(0.5/512.0);											\n\
+	gl_Position = vec4(position, 0.0, 1.0);													\n\
+}																							\n\
+";
@@ -1,11 +1,13 @@
 "																							\n\
 attribute vec2 position;																	\n\
 attribute vec2 coord;																		\n\
+uniform float offsetScale;																	\n\
 varying vec2 vCoord;																		\n\
 																							\n\
 void main()																					\n\
 {                                                                                           \n\
-	vCoord = coord;																			\n\
+	//coord only holds the displacement, the base follows from the grid position			\n\
+	vCoord = position*0.5 + 0.5 + coord*offsetScale;										\n\
 	gl_Position = vec4(position, 0.0, 1.0);													\n\
 }																							\n\
 ";
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "WaterSimulationThread.h"
+#include "RippleSimulation.h"
+#include <core/Clock.h>
+#include <core/Profiler.h>
+#include <string.h>
+
+//after a stall, drop missed ticks instead of running them all back to back
+static const int MAX_CATCH_UP_STEPS = 4;
+
+static int getUVFrameSize(const RippleSimulation* simulation)
+{
+	return simulation->GetWidth()*simulation->GetHeight()*getUVFormatSize(simulation->GetUVFormat());
+}
+
+static u8* allocUVStorage(const RippleSimulation* simulation)
+{
+	//zero offsets are the flat water
+	int frameSize = getUVFrameSize(simulation);
+	u8* storage = new u8[frameSize*3];
+	memset(storage, 0, frameSize*3);
+	return storage;
+}
+
+WaterSimulationThread::WaterSimulationThread(RippleSimulation* simulation, int stepsPerSecond)
+	:m_simulation(simulation)
+	,m_stepPeriod(1000000/(stepsPerSecond > 0 ? stepsPerSecond : 60))
+	,m_tickTime(0)
+	,m_uvStorage(allocUVStorage(simulation))
+	,m_uvBuffers(m_uvFrames, m_uvFrames + 1, m_uvFrames + 2)
+	,m_running(false)
+	,m_atRest(true)
+{
+	for (int i=0; i<3; ++i)
+	{
+		m_uvFrames[i].uv = m_uvStorage + i*getUVFrameSize(simulation);
+	}
+
+	pthread_mutex_init(&m_dropMutex, NULL);
+	pthread_cond_init(&m_dropCond, NULL);
+}
+
+WaterSimulationThread::~WaterSimulationThread()
+{
+	this->Stop();
+
+	pthread_cond_destroy(&m_dropCond);
+	pthread_mutex_destroy(&m_dropMutex);
+	delete[] m_uvStorage;
+}
+
+void WaterSimulationThread::Start()
+{
+	if (m_running.load())
+		return;
+
+	m_running.store(true);
+	pthread_create(&m_thread, NULL, &WaterSimulationThread::_threadMain, this);
+}
+
+void WaterSimulationThread::Stop()
+{
+	if (!m_running.load())
+		return;
+
+	//wake it if it sleeps on flat water
+	pthread_mutex_lock(&m_dropMutex);
+	m_running.store(false);
+	pthread_cond_signal(&m_dropCond);
+	pthread_mutex_unlock(&m_dropMutex);
+
+	pthread_join(m_thread, NULL);
+}
+
+void WaterSimulationThread::SetStepsPerSecond(int stepsPerSecond)
+{
+	m_stepPeriod.store(1000000/(stepsPerSecond > 0 ? stepsPerSecond : 60));
+}
+
+void WaterSimulationThread::QueueDrop(int x, int y, int depth)
+{
+	DropEvent drop = {x, y, depth, nullptr, false, 0, 0};
+
+	pthread_mutex_lock(&m_dropMutex);
+	m_pendingDrops.push_back(drop);
+	m_atRest.store(false);
+	pthread_cond_signal(&m_dropCond);
+	pthread_mutex_unlock(&m_dropMutex);
+}
+
+void WaterSimulationThread::QueueDrops(const DropEvent* drops, int count)
+{
+	//one lock for the whole batch
+	pthread_mutex_lock(&m_dropMutex);
+	m_pendingDrops.insert(m_pendingDrops.end(), drops, drops + count);
+	m_atRest.store(false);
+	pthread_cond_signal(&m_dropCond);
+	pthread_mutex_unlock(&m_dropMutex);
+}
+
+void WaterSimulationThread::Tick()
+{
+	PROFILE_SCOPE("WaterSimulationThread::Tick");
+
+	RowRange stepRows = this->ApplyDrops();
+
+	//the water is at rest and the reader already has it flat
+	if (stepRows.isEmpty() && m_publishedRows.isEmpty())
+	{
+		this->_updateRest(true);
+		return;
+	}
+
+	//the buffer is still flat outside the rows it had last time
+	UVFrame* frame = m_uvBuffers.getWriteBuffer();
+	RowRange rows = stepRows.merged(frame->activeRows);
+	int rowSize = m_simulation->GetWidth()*getUVFormatSize(m_simulation->GetUVFormat());
+	RowRange activeRows = m_simulation->Step(frame->uv + rows.begin*rowSize, rows);
+	frame->activeRows = activeRows;
+
+	m_uvBuffers.publish();
+	m_publishedRows = activeRows;
+	this->_updateRest(activeRows.isEmpty());
+}
+
+void WaterSimulationThread::_updateRest(bool flat)
+{
+	//drops queued during the step keep it busy
+	pthread_mutex_lock(&m_dropMutex);
+	m_atRest.store(flat && m_pendingDrops.empty());
+	pthread_mutex_unlock(&m_dropMutex);
+}
+
+RowRange WaterSimulationThread::ApplyDrops()
+{
+	this->_applyDrops();
+
+	RowRange stepRows = m_simulation->GetStepRows();
+	this->_updateRest(stepRows.isEmpty());
+	return stepRows;
+}
+
+void WaterSimulationThread::_applyDrops()
+{
+	//only swap under the lock so touches never wait for a step
+	pthread_mutex_lock(&m_dropMutex);
+	m_processingDrops.swap(m_pendingDrops);
+	pthread_mutex_unlock(&m_dropMutex);
+
+	for (size_t i=0; i<m_processingDrops.size(); ++i)
+	{
+		const DropEvent& drop = m_processingDrops[i];
+		if (drop.segment)
+			m_simulation->DropSegment(drop.fromX, drop.fromY, drop.x, drop.y, drop.depth);
+		else if (drop.stamp)
+			m_simulation->Drop(drop.x, drop.y, drop.stamp);
+		else
+			m_simulation->Drop(drop.x, drop.y, drop.depth);
+	}
+	m_processingDrops.clear();
+}
+
+void* WaterSimulationThread::_threadMain(void* param)
+{
+	reinterpret_cast<WaterSimulationThread*>(param)->_run();
+	return NULL;
+}
+
+void WaterSimulationThread::_run()
+{
+	u64 nextStep = getTimeMicroseconds();
+
+	while (m_running.load())
+	{
+		//flat water has nothing to step, sleep until a drop arrives
+		if (m_atRest.load())
+		{
+			m_tickTime.store(0);
+
+			pthread_mutex_lock(&m_dropMutex);
+			while (m_running.load() && m_pendingDrops.empty())
+				pthread_cond_wait(&m_dropCond, &m_dropMutex);
+			pthread_mutex_unlock(&m_dropMutex);
+
+			nextStep = getTimeMicroseconds();
+			continue;
+		}
+
+		u64 now = getTimeMicroseconds();
+		if (now < nextStep)
+		{
+			sleepMicroseconds(nextStep - now);
+			continue;
+		}
+
+		this->Tick();
+		m_tickTime.store(getTimeMicroseconds() - now);
+
+		u64 stepPeriod = m_stepPeriod.load();
+		nextStep += stepPeriod;
+		if (now > nextStep + MAX_CATCH_UP_STEPS*stepPeriod)
+			nextStep = now;
+	}
+}
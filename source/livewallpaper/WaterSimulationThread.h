@@ -0,0 +1,136 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <pthread.h>
+#include <core/types.h>
+#include <math/vector2d.h>
+#include <core/TripleBuffer.h>
+#include "RippleSimulation.h"
+
+//! Steps a RippleSimulation at a fixed rate and publishes the displaced
+//! coordinates through a lock-free triple buffer.
+//!
+//! After Start() the simulation runs on its own thread and the renderer only
+//! picks up the newest finished buffer, so neither side waits for the other.
+//! Without Start() the owner drives it by calling Tick() itself.
+//!
+//! Nothing is published while the water is at rest, the thread then sleeps
+//! until the next drop. Each buffer only has the rows that changed since it
+//! was last used rewritten.
+class WaterSimulationThread
+{
+public:
+	//! Offsets in the simulation's E_UV_Format, zero outside activeRows.
+	struct UVFrame
+	{
+		u8*					uv;
+		RowRange			activeRows;
+	};
+
+	WaterSimulationThread(RippleSimulation* simulation, int stepsPerSecond);
+	~WaterSimulationThread();
+
+	void Start();
+	void Stop();
+	bool IsRunning() const;
+
+	//! Takes effect from the next tick.
+	void SetStepsPerSecond(int stepsPerSecond);
+
+	//! No waves and no queued drops, the published coordinates are flat.
+	bool IsAtRest() const;
+
+	//! Time the last tick on the thread took over the tick period, above 1
+	//! the simulation falls behind.
+	float GetLoad() const;
+
+	//! Drains queued drops, steps once and publishes the result.
+	void Tick();
+
+	//! Drains queued drops into the simulation without stepping it and
+	//! returns the rows the next step may change, for owners that step the
+	//! simulation themselves.
+	RowRange ApplyDrops();
+
+	struct DropEvent
+	{
+		int x;
+		int y;
+		int depth;
+
+		//null drops the radial stamp of depth
+		const DropStamp* stamp;
+
+		//set for drags, sweeps the radial drop from the previous sample
+		bool segment;
+		int fromX;
+		int fromY;
+	};
+
+	//! Safe to call from any thread, applied on the next tick. Stamps must
+	//! outlive the drops.
+	void QueueDrop(int x, int y, int depth);
+	void QueueDrops(const DropEvent* drops, int count);
+
+	//consumer side, returns true when a newer buffer was taken
+	bool AcquireUVBuffer();
+	const UVFrame* GetUVFrame() const;
+
+private:
+	void _applyDrops();
+	//! m_atRest from whether the water is flat after the step
+	void _updateRest(bool flat);
+
+	static void* _threadMain(void* param);
+	void _run();
+
+private:
+	RippleSimulation*				m_simulation;
+	std::atomic<u64>				m_stepPeriod;
+	std::atomic<u64>				m_tickTime;
+
+	u8*								m_uvStorage;
+	UVFrame							m_uvFrames[3];
+	TripleBuffer<UVFrame>			m_uvBuffers;
+	RowRange						m_publishedRows;
+
+	pthread_t						m_thread;
+	std::atomic<bool>				m_running;
+	std::atomic<bool>				m_atRest;
+
+	pthread_mutex_t					m_dropMutex;
+	//signalled when drops arrive, the thread waits on it while at rest
+	pthread_cond_t					m_dropCond;
+	std::vector<DropEvent>			m_pendingDrops;
+	std::vector<DropEvent>			m_processingDrops;
+};
+
+inline bool
+WaterSimulationThread::IsRunning() const
+{
+	return m_running.load();
+}
+
+inline bool
+WaterSimulationThread::IsAtRest() const
+{
+	return m_atRest.load();
+}
+
+inline float
+WaterSimulationThread::GetLoad() const
+{
+	return float(m_tickTime.load())/m_stepPeriod.load();
+}
+
+inline bool
+WaterSimulationThread::AcquireUVBuffer()
+{
+	return m_uvBuffers.update();
+}
+
+inline const WaterSimulationThread::UVFrame*
+WaterSimulationThread::GetUVFrame() const
+{
+	return m_uvBuffers.getReadBuffer();
+}
@@ -1,4 +1,6 @@
 #include "esutils.h"
+#include <stdarg.h>
+#include <string.h>
 
 void esLogMessage ( const char *formatStr, ... )
 {
@@ -6,7 +8,11 @@ void esLogMessage ( const char *formatStr, ... )
 	char buf[BUFSIZ];
 
 	va_start ( params, formatStr );
+#if defined(_MSC_VER)
 	vsprintf_s ( buf, sizeof(buf),  formatStr, params );
+#else
+	vsnprintf ( buf, sizeof(buf),  formatStr, params );
+#endif
 
 	printf ( "%s", buf );
 
@@ -118,6 +124,58 @@ GLuint esLoadProgram ( const char *vertShaderSrc, const char *fragShaderSrc )
 	return programObject;
 }
 
+GLint esGetContextMajorVersion()
+{
+	//"OpenGL ES N.M <vendor specific>"
+	const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	const char* prefix = "OpenGL ES ";
+	if (version == NULL || strncmp(version, prefix, strlen(prefix)) != 0)
+		return 2;
+
+	return atoi(version + strlen(prefix));
+}
+
+static bool hasExtensionName(const char* extensions, const char* name)
+{
+	if (extensions == NULL)
+		return false;
+
+	//whole names only, GL_EXT_foo must not match GL_EXT_foo_bar
+	size_t length = strlen(name);
+	for (const char* found = strstr(extensions, name); found; found = strstr(found + length, name))
+	{
+		bool startsName = (found == extensions || found[-1] == ' ');
+		bool endsName = (found[length] == ' ' || found[length] == '\0');
+		if (startsName && endsName)
+			return true;
+	}
+	return false;
+}
+
+GLboolean esHasExtension(const char* name)
+{
+	const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+	return hasExtensionName(extensions, name) ? GL_TRUE : GL_FALSE;
+}
+
+static EGLContext createContext(EGLDisplay display, EGLConfig config)
+{
+#if defined(USING_GLES_30)
+	EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE, EGL_NONE };
+#else
+	EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE, EGL_NONE };
+#endif
+
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs );
+	if ( context == EGL_NO_CONTEXT && contextAttribs[1] > 2 )
+	{
+		//drivers without ES3 still run everything but the streaming paths
+		contextAttribs[1] = 2;
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs );
+	}
+	return context;
+}
+
 EGLBoolean CreateEGLContext(EGLNativeWindowType  hWnd,
 							EGLDisplay* eglDisplay,
 							EGLContext* eglContext,
@@ -132,14 +190,12 @@ EGLBoolean CreateEGLContext(EGLNativeWindowType  hWnd,
 	EGLSurface surface;
 	EGLConfig config;
 
-#if 0//USING_GLES_30
-	EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE, EGL_NONE };
-#else
-	EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE, EGL_NONE };
-#endif
-
 	// Get Display
+#if defined(_WIN32)
 	display = eglGetDisplay(GetDC(hWnd));
+#else
+	display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+#endif
 	if (display == EGL_NO_DISPLAY)
 		return EGL_FALSE;
 
@@ -156,7 +212,127 @@ EGLBoolean CreateEGLContext(EGLNativeWindowType  hWnd,
 	if(surface == EGL_NO_SURFACE)
 		return EGL_FALSE;
 
-	context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs );
+	context = createContext(display, config);
+	if ( context == EGL_NO_CONTEXT )
+		return EGL_FALSE;
+
+	if ( !eglMakeCurrent(display, surface, surface, context) )
+		return EGL_FALSE;
+
+	*eglDisplay = display;
+	*eglSurface = surface;
+	*eglContext = context;
+
+	return EGL_TRUE;
+}
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA		0x31DD
+#endif
+#ifndef EGL_PLATFORM_DEVICE_EXT
+#define EGL_PLATFORM_DEVICE_EXT				0x313F
+#endif
+
+typedef EGLDisplay (EGLAPIENTRYP PFNHEADLESSGETPLATFORMDISPLAY) (EGLenum platform, void* nativeDisplay, const EGLint* attribList);
+typedef EGLBoolean (EGLAPIENTRYP PFNHEADLESSQUERYDEVICES) (EGLint maxDevices, void** devices, EGLint* numDevices);
+
+//a display that needs no window system, for boxes where the default one wants
+//an X server that is not there
+static EGLDisplay getHeadlessDisplay()
+{
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	PFNHEADLESSGETPLATFORMDISPLAY getPlatformDisplay =
+		(PFNHEADLESSGETPLATFORMDISPLAY)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (!clientExtensions || !getPlatformDisplay)
+		return EGL_NO_DISPLAY;
+
+	if (hasExtensionName(clientExtensions, "EGL_MESA_platform_surfaceless"))
+	{
+		EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+			return display;
+	}
+
+	//the first device, a render node without any window system
+	PFNHEADLESSQUERYDEVICES queryDevices = (PFNHEADLESSQUERYDEVICES)eglGetProcAddress("eglQueryDevicesEXT");
+	if (hasExtensionName(clientExtensions, "EGL_EXT_platform_device") && queryDevices)
+	{
+		void* device = NULL;
+		EGLint deviceCount = 0;
+		if (queryDevices(1, &device, &deviceCount) && deviceCount > 0)
+		{
+			EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, device, NULL);
+			if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+				return display;
+		}
+	}
+	return EGL_NO_DISPLAY;
+}
+
+static bool chooseConfig(EGLDisplay display, const EGLint attribList[], EGLint surfaceType, EGLConfig* config)
+{
+	//the caller's attributes plus the surface and api the headless context needs
+	EGLint attribs[64];
+	int count = 0;
+	while (attribList[count] != EGL_NONE && count < 58)
+	{
+		attribs[count] = attribList[count];
+		attribs[count + 1] = attribList[count + 1];
+		count += 2;
+	}
+	attribs[count++] = EGL_SURFACE_TYPE;
+	attribs[count++] = surfaceType;
+	attribs[count++] = EGL_RENDERABLE_TYPE;
+	attribs[count++] = EGL_OPENGL_ES2_BIT;
+	attribs[count] = EGL_NONE;
+
+	EGLint numConfigs = 0;
+	return eglChooseConfig(display, attribs, config, 1, &numConfigs) && numConfigs > 0;
+}
+
+EGLBoolean CreateHeadlessEGLContext(EGLint width,
+									EGLint height,
+									EGLDisplay* eglDisplay,
+									EGLContext* eglContext,
+									EGLSurface* eglSurface,
+									EGLint attribList[])
+{
+	EGLint majorVersion;
+	EGLint minorVersion;
+	EGLContext context;
+	EGLSurface surface = EGL_NO_SURFACE;
+	EGLConfig config;
+
+	EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display,&majorVersion,&minorVersion))
+	{
+		display = getHeadlessDisplay();
+		if (display == EGL_NO_DISPLAY)
+			return EGL_FALSE;
+		esLogMessage("no default display, rendering on a headless platform display\n");
+	}
+
+	eglBindAPI(EGL_OPENGL_ES_API);
+
+	if (chooseConfig(display, attribList, EGL_PBUFFER_BIT, &config))
+	{
+		EGLint surfaceAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+		surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+	}
+
+	if (surface == EGL_NO_SURFACE)
+	{
+		//without pbuffers only framebuffer objects can be rendered to
+		if (!hasExtensionName(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+			return EGL_FALSE;
+
+		if (!chooseConfig(display, attribList, 0, &config))
+			return EGL_FALSE;
+
+		esLogMessage("no pbuffer config, rendering surfaceless\n");
+	}
+
+	context = createContext(display, config);
 	if ( context == EGL_NO_CONTEXT )
 		return EGL_FALSE;
 
@@ -22,12 +22,29 @@ GLuint LoadShader ( GLenum type, const char *shaderSrc );
 
 GLuint esLoadProgram ( const char *vertShaderSrc, const char *fragShaderSrc );
 
+//! Major version of the current context, parsed from GL_VERSION.
+GLint esGetContextMajorVersion();
+
+//! True when the current context lists the extension in GL_EXTENSIONS.
+GLboolean esHasExtension(const char* name);
+
 EGLBoolean CreateEGLContext(EGLNativeWindowType  hWnd,
 							EGLDisplay* eglDisplay,
 							EGLContext* eglContext,
 							EGLSurface* eglSurface,
 							EGLint attribList[]);
 
+//! Off-screen context on the default display: a width x height pbuffer, or
+//! no surface at all when the driver only has EGL_KHR_surfaceless_context.
+//! Without a window system to open the default display on, it falls back to
+//! the Mesa surfaceless platform or the first EGL device.
+EGLBoolean CreateHeadlessEGLContext(EGLint width,
+									EGLint height,
+									EGLDisplay* eglDisplay,
+									EGLContext* eglContext,
+									EGLSurface* eglSurface,
+									EGLint attribList[]);
+
 #if defined(_DEBUG)
 #define GETGLERROR() \
 	if(glGetError() != GL_NO_ERROR) \
@@ -23,7 +23,15 @@ FrameBuffer::FrameBuffer(GLuint width,GLuint height,unsigned int flags)
 
 		glGenTextures(1, &m_targetTexture);
 		glBindTexture(GL_TEXTURE_2D,m_targetTexture);
-		if(m_flags & EFBT_TEXTURE_WHITE)
+		if(m_flags & EFBT_TEXTURE_RG16F)
+		{
+			glTexImage2D(GL_TEXTURE_2D,0,GL_RG16F,m_width,m_height,0,GL_RG,GL_HALF_FLOAT,0);
+		}
+		else if(m_flags & EFBT_TEXTURE_RG32F)
+		{
+			glTexImage2D(GL_TEXTURE_2D,0,GL_RG32F,m_width,m_height,0,GL_RG,GL_FLOAT,0);
+		}
+		else if(m_flags & EFBT_TEXTURE_WHITE)
 		{
 			std::vector<GLubyte> textureData(m_width*m_height*bytesPerPixel,125);
 			GLubyte* pData = new GLubyte[m_width*m_height*bytesPerPixel];
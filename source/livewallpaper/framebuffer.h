@@ -10,7 +10,13 @@ enum
 	EFBT_TEXTURE_DEPTH = 1 << 3,
 	EFBT_TEXTURE_WHITE = 1 << 4,
 
-	EFBT_TEXTURE = EFBT_TEXTURE_RGB8 | EFBT_TEXTURE_RGBA8,
+	//two half float channels, needs GL_EXT_color_buffer_(half_)float to render to
+	EFBT_TEXTURE_RG16F = 1 << 5,
+
+	//two float channels, needs GL_EXT_color_buffer_float, not filterable
+	EFBT_TEXTURE_RG32F = 1 << 6,
+
+	EFBT_TEXTURE = EFBT_TEXTURE_RGB8 | EFBT_TEXTURE_RGBA8 | EFBT_TEXTURE_RG16F | EFBT_TEXTURE_RG32F,
 };
 
 class Texture2D;
@@ -41,13 +47,7 @@ private:
 
 inline void FrameBuffer::Begin()
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_targetTexture);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_depthBuffer);
-
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_targetTexture, 0);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
-
+	//attachments are set up once and travel with the framebuffer on Swap()
 	glBindFramebuffer(GL_FRAMEBUFFER,m_frameBuffer);
 }
 
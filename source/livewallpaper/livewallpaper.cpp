@@ -1,8 +1,13 @@
 #include "livewallpaper.h"
 #include "esutils.h"
 #include "water.h"
+#include "GpuProfiler.h"
+#include "TouchRecording.h"
+#include "QualityGovernor.h"
+#include "ShaderCache.h"
 
 #include <math/matrix4.h>
+#include <algorithm>
 
 using namespace jenny;
 jenny::matrix4 g_viewMatrix;
@@ -13,10 +18,22 @@ jenny::matrix4 g_viewMatrixOrc;
 jenny::matrix4 g_projectMatrixOrtho;
 jenny::matrix4 g_viewProjectMatrixOrc;
 
-LiveWallPaper::LiveWallPaper():	m_hWnd(nullptr)
+//frame time in microseconds the quality governor keeps the frames under
+static const float GOVERNOR_FRAME_BUDGET = 1000000.0f/60.0f;
+
+LiveWallPaper::LiveWallPaper():	m_window(0)
 								,m_width(0)
 								,m_height(0)
+								,m_eglDisplay(EGL_NO_DISPLAY)
+								,m_eglContext(EGL_NO_CONTEXT)
+								,m_eglSurface(EGL_NO_SURFACE)
 								,m_water(NULL)
+								,m_frameIndex(0)
+								,m_presentPending(true)
+								,m_touchRecording(NULL)
+								,m_recordingStartFrame(0)
+								,m_qualityGovernor(NULL)
+								,m_frameStart(0)
 
 {
 
@@ -25,15 +42,19 @@ LiveWallPaper::LiveWallPaper():	m_hWnd(nullptr)
 
 LiveWallPaper::~LiveWallPaper()
 {
+	delete m_qualityGovernor;
+	delete m_water;
+	GpuProfiler::deleteInstance();
+	ShaderCache::deleteInstance();
 
 }
 
 
-void LiveWallPaper::Init(int width, int height, HWND hwnd)
+bool LiveWallPaper::Init(int width, int height, EGLNativeWindowType window, const WaterSettings* settings)
 {
 	m_width = width;
 	m_height = height;
-	m_hWnd = hwnd;
+	m_window = window;
 
 	GLuint flags = ES_WINDOW_RGB;
 	EGLint attribList[] =
@@ -47,7 +68,18 @@ void LiveWallPaper::Init(int width, int height, HWND hwnd)
 		EGL_SAMPLE_BUFFERS, (flags & ES_WINDOW_MULTISAMPLE) ? 1 : 0,
 		EGL_NONE
 	};
-	CreateEGLContext(m_hWnd,&m_eglDisplay,&m_eglContext,&m_eglSurface,attribList);
+	EGLBoolean created;
+	if (m_window)
+		created = CreateEGLContext(m_window,&m_eglDisplay,&m_eglContext,&m_eglSurface,attribList);
+	else
+		created = CreateHeadlessEGLContext(m_width,m_height,&m_eglDisplay,&m_eglContext,&m_eglSurface,attribList);
+
+	//nothing below works without a current context
+	if (!created)
+	{
+		esLogMessage("can't create an EGL context\n");
+		return false;
+	}
 
 	//initialize matrixs
 	//view matrix
@@ -79,40 +111,155 @@ void LiveWallPaper::Init(int width, int height, HWND hwnd)
 	//ortho projection matrix
 	g_viewProjectMatrixOrc.setbyproduct_nocheck(g_projectMatrixOrtho, g_viewMatrixOrc);
 
+	//gpu timings only matter when somebody collects the cpu ones
+	if (Profiler::instance() && GpuProfiler::IsSupported())
+		GpuProfiler::newInstance();
+
+	//programs linked on an earlier start load from their binaries
+	if (settings && settings->shaderCacheDirectory && ShaderCache::IsSupported())
+		ShaderCache::newInstance()->SetDirectory(settings->shaderCacheDirectory);
+
 	m_water = new Water(m_width,m_height,200.0f);
-	m_water->Init();
+	m_water->Init(settings ? *settings : WaterSettings());
+	m_touchBatch.reserve(MAX_PENDING_TOUCHES);
+	return true;
 }
 
 
 void LiveWallPaper::Update()
 {
-	//update touches
-	if (m_touchQueue.size() > 0)
+	PROFILE_SCOPE("LiveWallPaper::Update");
+	m_frameStart = getTimeMicroseconds();
+
+	//take every pending touch, however many arrived since the last frame
+	TouchEvent touch;
+	m_touchBatch.clear();
+	while (m_touchRing.pop(touch))
+		m_touchBatch.push_back(touch);
+
+	if (!m_touchBatch.empty())
 	{
-		TouchPos touch = m_touchQueue.front();
-		m_touchQueue.pop();
-		m_water->onTouch(touch.X, touch.Y);
-		//m_water->onTouch(400, 400);
-	}
+		//oldest touch to the frame that applies it
+		if (Profiler::instance())
+			Profiler::instance()->record("touch latency", m_touchBatch.front().Time, getTimeMicroseconds());
 
-	m_touchQueue.empty();
+		m_water->onTouches(&m_touchBatch[0], int(m_touchBatch.size()));
+
+		if (m_touchRecording)
+		{
+			for (size_t i=0; i<m_touchBatch.size(); ++i)
+				m_touchRecording->Add(m_frameIndex - m_recordingStartFrame, m_touchBatch[i]);
+		}
+	}
 
 	m_water->Update();
+	++m_frameIndex;
 }
 
-void LiveWallPaper::Render()
+bool LiveWallPaper::Render()
 {
+	PROFILE_SCOPE("LiveWallPaper::Render");
+
+	if (GpuProfiler::instance())
+		GpuProfiler::instance()->Collect();
+
+	//the screen keeps its old content until the programs are linked
+	if (!m_water->IsReady())
+		return false;
+
+	//the last frame is still on screen, neither redraw nor swap it. Every
+	//presented frame is drawn whole, so the back buffer need not be preserved
+	if (!m_water->UpdateSurface() && !m_presentPending)
+		return false;
+	m_presentPending = false;
+
 	glViewport ( 0, 0, m_width, m_height);
 	glClear ( GL_COLOR_BUFFER_BIT );
 
 	//render water
 	m_water->Render();
 
-	eglSwapBuffers ( m_eglDisplay, m_eglSurface);
+	//the swap is left out, it waits for vsync, a gpu that falls behind shows
+	//up as waits for the uv stream instead
+	if (m_qualityGovernor)
+	{
+		float load = float(getTimeMicroseconds() - m_frameStart)/GOVERNOR_FRAME_BUDGET;
+		load = std::max(load, m_water->GetSimulationLoad());
+		if (m_qualityGovernor->AddFrame(load))
+			this->_applyQualityTier();
+	}
+
+	//surfaceless contexts have nothing to present
+	if (m_eglSurface != EGL_NO_SURFACE)
+		eglSwapBuffers ( m_eglDisplay, m_eglSurface);
+	return true;
+}
+
+void LiveWallPaper::Invalidate()
+{
+	m_presentPending = true;
 }
 
 void LiveWallPaper::OnTouch(int x, int y)
 {
-	TouchPos touchPos(x,y);
-	m_touchQueue.push(touchPos);
+	//a full ring means the consumer stalled, losing the touch beats blocking
+	//the input thread
+	m_touchRing.push(TouchEvent(x, y, getTimeMicroseconds()));
+}
+
+void LiveWallPaper::SetTouchRecording(TouchRecording* recording)
+{
+	m_touchRecording = recording;
+	m_recordingStartFrame = m_frameIndex;
+	if (m_touchRecording)
+		m_touchRecording->SetScreenSize(m_width, m_height);
+}
+
+void LiveWallPaper::SetSwapInterval(int interval)
+{
+	if (m_eglSurface != EGL_NO_SURFACE)
+		eglSwapInterval(m_eglDisplay, interval);
+}
+
+bool LiveWallPaper::IsIdle() const
+{
+	//m_presentPending stays set until a frame after the programs linked
+	return !m_presentPending && m_touchRing.isEmpty() && m_water->IsAtRest();
+}
+
+void LiveWallPaper::SetAdaptiveQuality(bool enabled)
+{
+	if (enabled == (m_qualityGovernor != NULL))
+		return;
+
+	if (enabled)
+	{
+		m_qualityGovernor = new QualityGovernor();
+		this->_applyQualityTier();
+	}
+	else
+	{
+		delete m_qualityGovernor;
+		m_qualityGovernor = NULL;
+	}
+}
+
+void LiveWallPaper::_applyQualityTier()
+{
+	const QualityTier& tier = m_qualityGovernor->GetTierSettings(m_qualityGovernor->GetTier());
+	m_water->SetCellSize(tier.cellSize);
+	m_water->SetMeshLod(tier.meshLod);
+	m_water->SetSimulationRate(tier.simulationRate);
+	esLogMessage("quality tier %d: %dx%d grid, mesh lod %d, %d steps/s\n", m_qualityGovernor->GetTier(),
+		m_water->GetGridWidth(), m_water->GetGridHeight(), m_water->GetMeshLod(), tier.simulationRate);
+}
+
+u64 LiveWallPaper::GetHeightChecksum() const
+{
+	return m_water ? m_water->GetHeightChecksum() : 0;
+}
+
+void LiveWallPaper::OnTouchUp()
+{
+	m_touchRing.push(TouchEvent(0, 0, getTimeMicroseconds(), ETP_UP));
 }
\ No newline at end of file
@@ -1,16 +1,14 @@
 #include <GLES3/gl3.h>
 #include <EGL/egl.h>
-#include <queue>
+#include <vector>
 #include <core/singleton.h>
-
-struct TouchPos
-{
-	TouchPos(int x, int y):X(x),Y(y){}
-	int X;
-	int Y;
-};
+#include <core/SpscRing.h>
+#include "TouchEvent.h"
 
 class Water;
+struct WaterSettings;
+class TouchRecording;
+class QualityGovernor;
 class LiveWallPaper:public Singleton<LiveWallPaper>
 {
 	friend Singleton<LiveWallPaper>;
@@ -20,13 +18,54 @@ protected:
 	~LiveWallPaper();
 
 public:
-	void Init(int width, int height, HWND hwnd);
+	//! A null window renders off-screen into a pbuffer, see
+	//! CreateHeadlessEGLContext(). Null settings use the WaterSettings defaults.
+	//! False when there is no EGL context, the wallpaper must not be used then.
+	bool Init(int width, int height, EGLNativeWindowType window, const WaterSettings* settings = nullptr);
 	void Update();
-	void Render();
+
+	//! Skips the draw and the swap when the frame would look like the one
+	//! on screen. True when it presented a new frame.
+	bool Render();
+
+	//! The frame on screen was lost or resized, the next Render() redraws it
+	//! even if the water did not move.
+	void Invalidate();
+	//! Lock-free, may run on an input thread. Every touch queued before
+	//! Update() reaches the water in that frame.
 	void OnTouch(int x, int y);
 
+	//! The finger was lifted, the next touch starts a new stroke.
+	void OnTouchUp();
+
+	//! Appends every touch applied from now on, with its frame counted from
+	//! this call. Null stops recording, the recording stays the caller's.
+	void SetTouchRecording(TouchRecording* recording);
+	TouchRecording* GetTouchRecording() const;
+
+	//! Frames updated since Init().
+	u32 GetFrameIndex() const;
+
+	//! See Water::GetHeightChecksum().
+	u64 GetHeightChecksum() const;
+
+	//! Vsync intervals per swap, 0 swaps without waiting. Needs a window.
+	void SetSwapInterval(int interval);
+
+	//! No touches pending, the water at rest and its last frame presented,
+	//! rendering would only repeat it. The loop may then wait for input.
+	bool IsIdle() const;
+
+	//! Lets a QualityGovernor trade grid size, mesh detail and simulation
+	//! rate for frame time. Enabling applies its starting tier right away.
+	void SetAdaptiveQuality(bool enabled);
+	QualityGovernor* GetQualityGovernor() const;
+
 private:
-	HWND		m_hWnd;
+	void _applyQualityTier();
+
+private:
+	EGLNativeWindowType	m_window;
 
 	GLuint		m_width;
 	GLuint		m_height;
@@ -36,6 +75,41 @@ private:
 	EGLSurface	m_eglSurface;
 
 	Water*		m_water;
+	u32			m_frameIndex;
+
+	//the surface needs a present whether or not the water moved
+	bool		m_presentPending;
+
+	TouchRecording*	m_touchRecording;
+	u32				m_recordingStartFrame;
+
+	QualityGovernor*	m_qualityGovernor;
+	u64					m_frameStart;
+
+	enum
+	{
+		MAX_PENDING_TOUCHES = 1024,
+	};
+
+	//touches from OnTouch(), drained into m_touchBatch every frame
+	SpscRing<TouchEvent, MAX_PENDING_TOUCHES>	m_touchRing;
+	std::vector<TouchEvent>						m_touchBatch;
+};
+
+inline TouchRecording*
+LiveWallPaper::GetTouchRecording() const
+{
+	return m_touchRecording;
+}
 
-	std::queue<TouchPos>	m_touchQueue;
-};
\ No newline at end of file
+inline QualityGovernor*
+LiveWallPaper::GetQualityGovernor() const
+{
+	return m_qualityGovernor;
+}
+
+inline u32
+LiveWallPaper::GetFrameIndex() const
+{
+	return m_frameIndex;
+}
@@ -1,82 +1,222 @@
 #include "shader.h"
+#include "esutils.h"
+#include "ShaderCache.h"
+#include "UniformBlocks.h"
 #include <core/string_hash.h>
 
+//GL_KHR_parallel_shader_compile, not in every gl2ext.h this builds against
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR        0x91B1
+#endif
 
-Shader::Shader(const char* verStr, const char* fragStr):mShaderProgram(0)
+typedef void (GL_APIENTRYP PFNSHADERMAXCOMPILERTHREADS) (GLuint count);
+
+//lets the driver compile and link on its own threads, checked once per process
+static bool enableParallelCompile()
+{
+    static int supported = -1;
+    if (supported < 0)
+    {
+        PFNSHADERMAXCOMPILERTHREADS maxShaderCompilerThreads = nullptr;
+        if (esHasExtension("GL_KHR_parallel_shader_compile"))
+            maxShaderCompilerThreads = (PFNSHADERMAXCOMPILERTHREADS)eglGetProcAddress("glMaxShaderCompilerThreadsKHR");
+
+        //as many threads as the driver likes
+        if (maxShaderCompilerThreads)
+            maxShaderCompilerThreads(0xFFFFFFFF);
+        supported = maxShaderCompilerThreads ? 1 : 0;
+    }
+    return supported != 0;
+}
+
+//hash of every registered slot, a slot is its index
+static std::vector<size_t>& getUniformSlotHashes()
+{
+    static std::vector<size_t> hashes;
+    return hashes;
+}
+
+#if defined(_DEBUG)
+//name of every hash seen, registered or reflected, two names sharing a hash
+//would set each other's uniforms
+static void checkUniformHash(size_t hashedName, const char* name)
+{
+    static std::unordered_map<size_t, std::string> names;
+    auto found = names.insert(std::make_pair(hashedName, std::string(name)));
+    JENNY_ASSERT(found.first->second == name);
+}
+#endif
+
+//bytes of one element of a uniform
+static u32 getUniformValueSize(GLenum valueType)
+{
+    switch (valueType)
+    {
+    case GL_FLOAT_VEC2:
+    case GL_INT_VEC2:
+    case GL_BOOL_VEC2:      return 8;
+    case GL_FLOAT_VEC3:
+    case GL_INT_VEC3:
+    case GL_BOOL_VEC3:      return 12;
+    case GL_FLOAT_VEC4:
+    case GL_INT_VEC4:
+    case GL_BOOL_VEC4:
+    case GL_FLOAT_MAT2:     return 16;
+    case GL_FLOAT_MAT3:     return 36;
+    case GL_FLOAT_MAT4:     return 64;
+    default:                return 4;
+    }
+}
+
+UniformSlot registerUniformSlot(size_t hashedName, const char* name)
+{
+    //CTHASH only hashes the first 20 characters
+    JENNY_ASSERT(hashedName == RTHASH(name));
+#if defined(_DEBUG)
+    checkUniformHash(hashedName, name);
+#endif
+
+    std::vector<size_t>& hashes = getUniformSlotHashes();
+    for (size_t i = 0; i < hashes.size(); ++i)
+    {
+        if (hashes[i] == hashedName)
+            return UniformSlot(i);
+    }
+    hashes.push_back(hashedName);
+    return UniformSlot(hashes.size() - 1);
+}
+
+
+Shader::Shader(const char* verStr, const char* fragStr, bool deferLink):mShaderProgram(0)
+                                                        ,m_vertexShader(0)
+                                                        ,m_fragmentShader(0)
+                                                        ,m_linkPending(false)
+                                                        ,m_cacheKey(0)
                                                         ,m_ShaderAttributes(nullptr)
                                                         ,m_ShaderAttributesNum(0)
+                                                        ,m_vertexAttributeMask(0)
+                                                        ,m_vertexAttributeLayoutKey(0)
+                                                        ,m_ShaderUniforms(nullptr)
 {
-   GLuint vertShader = this->loadShader(GL_VERTEX_SHADER,verStr);
-   GLuint fragShader = this->loadShader(GL_FRAGMENT_SHADER, fragStr);
+   mShaderProgram = glCreateProgram();
+   if (!mShaderProgram)
+       return;
 
-   if (vertShader && fragShader)
+   //a cached binary links without compiling anything
+   ShaderCache* cache = ShaderCache::instance();
+   if (cache)
    {
-       mShaderProgram = glCreateProgram();
-       if(mShaderProgram)
+       m_cacheKey = cache->GetKey(verStr, fragStr);
+       if (cache->Load(m_cacheKey, mShaderProgram))
        {
-           glAttachShader(mShaderProgram,vertShader);
-           glAttachShader(mShaderProgram,fragShader);
-
-           glLinkProgram(mShaderProgram);
-
-           GLint linked;
-           glGetProgramiv(mShaderProgram,GL_LINK_STATUS,&linked);
-
-		   if(linked)
-		   {
-			   generateShaderInfo(mShaderProgram);
-		   }
-		   else
-           {
-               glDeleteProgram(mShaderProgram);
-               mShaderProgram = 0;
-           }
+           generateShaderInfo(mShaderProgram);
+           return;
        }
    }
 
-   glDeleteShader(vertShader);
-   glDeleteShader(fragShader);
+   //nothing below waits for the compiler, finishLink() asks for the results
+   enableParallelCompile();
+   m_vertexShader = this->loadShader(GL_VERTEX_SHADER,verStr);
+   m_fragmentShader = this->loadShader(GL_FRAGMENT_SHADER, fragStr);
+   if (m_vertexShader && m_fragmentShader)
+   {
+       glAttachShader(mShaderProgram,m_vertexShader);
+       glAttachShader(mShaderProgram,m_fragmentShader);
+       if (cache)
+           glProgramParameteri(mShaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+       glLinkProgram(mShaderProgram);
+   }
+   m_linkPending = true;
 
-   
+   if (!deferLink)
+       this->finishLink();
 }
 
 Shader::~Shader()
 {
+	glDeleteShader(m_vertexShader);
+	glDeleteShader(m_fragmentShader);
 	glDeleteProgram(mShaderProgram);
 	delete[] reinterpret_cast<char*>(m_ShaderAttributes);
-	delete[] reinterpret_cast<char*>(mShaderUniformsInfo.crbegin()->second);
+	delete[] reinterpret_cast<char*>(m_ShaderUniforms);
 }
 
-
-GLuint 
-Shader::loadShader ( GLenum type, const char* shaderStr)
+bool
+Shader::poll()
 {
-    GLuint shader;
-    GLint compiled;
+    if (!m_linkPending)
+        return true;
 
-    shader = glCreateShader ( type );
-    if ( shader == 0 )
-        return 0;
+    if (enableParallelCompile())
+    {
+        GLint completed = GL_FALSE;
+        glGetProgramiv(mShaderProgram, GL_COMPLETION_STATUS_KHR, &completed);
+        if (!completed)
+            return false;
+    }
 
-    glShaderSource ( shader, 1, &shaderStr, NULL );
-    glCompileShader ( shader );
-    glGetShaderiv ( shader, GL_COMPILE_STATUS, &compiled );
+    this->finishLink();
+    return true;
+}
 
-    if ( !compiled ) 
+void
+Shader::finishLink()
+{
+    GLint linked = GL_FALSE;
+    if (m_vertexShader && m_fragmentShader)
+        glGetProgramiv(mShaderProgram,GL_LINK_STATUS,&linked);
+
+    if(linked)
+    {
+        generateShaderInfo(mShaderProgram);
+
+        ShaderCache* cache = ShaderCache::instance();
+        if (cache)
+            cache->Store(m_cacheKey, mShaderProgram);
+    }
+    else
     {
-        GLint infoLen = 0;
-		GLint len = 0;
-        glGetShaderiv ( shader, GL_INFO_LOG_LENGTH, &infoLen );
-        if ( infoLen > 1 )
+        GLuint shaders[] = {m_vertexShader, m_fragmentShader};
+        for (int i = 0; i < 2; ++i)
         {
-            char* infoLog = reinterpret_cast<char*>(malloc(sizeof(char) * infoLen));
-            glGetShaderInfoLog ( shader, infoLen, &len, infoLog );    
-            free ( infoLog );
+            GLint compiled = GL_FALSE;
+            GLint infoLen = 0;
+            if (shaders[i])
+            {
+                glGetShaderiv ( shaders[i], GL_COMPILE_STATUS, &compiled );
+                glGetShaderiv ( shaders[i], GL_INFO_LOG_LENGTH, &infoLen );
+            }
+            if ( !compiled && infoLen > 1 )
+            {
+                char* infoLog = reinterpret_cast<char*>(malloc(sizeof(char) * infoLen));
+                glGetShaderInfoLog ( shaders[i], infoLen, NULL, infoLog );
+                esLogMessage ( "Error compiling shader:\n%s\n", infoLog );
+                free ( infoLog );
+            }
         }
-        glDeleteShader ( shader );
-        return 0;
+
+        glDeleteProgram(mShaderProgram);
+        mShaderProgram = 0;
     }
 
+    //attached ones are only flagged, they go with the program
+    glDeleteShader(m_vertexShader);
+    glDeleteShader(m_fragmentShader);
+    m_vertexShader = 0;
+    m_fragmentShader = 0;
+    m_linkPending = false;
+}
+
+
+GLuint 
+Shader::loadShader ( GLenum type, const char* shaderStr)
+{
+    GLuint shader = glCreateShader ( type );
+    if ( shader == 0 )
+        return 0;
+
+    glShaderSource ( shader, 1, &shaderStr, NULL );
+    glCompileShader ( shader );
     return shader;
 }
 
@@ -116,6 +256,50 @@ Shader::generateShaderInfo(GLuint shaderProgram)
 		delete[] nameBuffer;
 	}
 
+    //FNV style hash of the location of every known attribute in attribute
+    //order, independent of the order the program lists them in
+    s32 locations[static_cast<int>(E_Vertex_Attribute::EVA_COUNT)];
+    for (u32 i = 0; i < m_ShaderAttributesNum; ++i)
+    {
+        int attribute = static_cast<int>(m_ShaderAttributes[i].attributeType);
+        if (attribute < static_cast<int>(E_Vertex_Attribute::EVA_COUNT))
+        {
+            m_vertexAttributeMask |= 1u << attribute;
+            locations[attribute] = m_ShaderAttributes[i].location;
+        }
+    }
+
+    u64 key = 14695981039346656037ULL;
+    for (int i = 0; i < static_cast<int>(E_Vertex_Attribute::EVA_COUNT); ++i)
+    {
+        u64 value = (m_vertexAttributeMask & (1u << i)) ? u64(i) << 32 | u32(locations[i]) : u64(-1);
+        key = (key ^ value)*1099511628211ULL;
+    }
+    m_vertexAttributeLayoutKey = key;
+
+    //shared blocks go to their fixed binding point, one buffer bound there
+    //serves every program
+    if (esGetContextMajorVersion() >= 3)
+    {
+        int blockCount = 0;
+        glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+        for (int i = 0; i < blockCount; ++i)
+        {
+            char blockName[64];
+            glGetActiveUniformBlockName(shaderProgram, i, sizeof(blockName), NULL, blockName);
+            E_Uniform_Block block = getUniformBlock(blockName);
+            if (block == EUB_COUNT)
+                continue;
+
+#if defined(_DEBUG)
+            //the GLSL block must not outgrow its C++ struct
+            GLint dataSize = 0;
+            glGetActiveUniformBlockiv(shaderProgram, i, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+            JENNY_ASSERT(u32(dataSize) <= getUniformBlockSize(block));
+#endif
+            glUniformBlockBinding(shaderProgram, i, block);
+        }
+    }
 
     int uniformCount = 0;
     glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORMS, &uniformCount);
@@ -129,6 +313,8 @@ Shader::generateShaderInfo(GLuint shaderProgram)
 
 		char* uniformBuffer = new char[sizeof(ShaderUniformDef)*uniformCount];
 		ShaderUniformDef* uniformDef = reinterpret_cast<ShaderUniformDef*>(uniformBuffer);
+		m_ShaderUniforms = uniformDef;
+		size_t shadowSize = 0;
 
         for(int i=0; i<uniformCount; ++i)
         {
@@ -137,12 +323,37 @@ Shader::generateShaderInfo(GLuint shaderProgram)
             glGetActiveUniform(shaderProgram, i, maxUniformLen,0,&arraySize, &valueType, nameBuffer);
             GLint loc = glGetUniformLocation(shaderProgram,nameBuffer);
 			size_t hashedName =  RTHASH(nameBuffer);
+#if defined(_DEBUG)
+			checkUniformHash(hashedName, nameBuffer);
+#endif
 			uniformDef->arraySize = arraySize;
 			uniformDef->valueType = valueType;
 			uniformDef->location = loc;
+			uniformDef->shadowOffset = u32(shadowSize);
+			//block members have no location and no shadow
+			uniformDef->shadowSize = (loc >= 0) ? getUniformValueSize(valueType)*arraySize : 0;
+			uniformDef->shadowValid = false;
+			shadowSize += uniformDef->shadowSize;
 			mShaderUniformsInfo.insert(std::pair<size_t, ShaderUniformDef*>(hashedName,uniformDef));
 			uniformDef++;
         }
 		delete []nameBuffer;
+
+        m_uniformShadow.resize(shadowSize);
     }
+}
+
+ShaderUniformDef*
+Shader::resolveUniform( UniformSlot slot )
+{
+    //first use of the slot in this program, look the name up once
+    const std::vector<size_t>& hashes = getUniformSlotHashes();
+    JENNY_ASSERT(slot < hashes.size());
+    if (slot >= m_uniformSlots.size())
+        m_uniformSlots.resize(hashes.size(), -2);
+
+    auto val = mShaderUniformsInfo.find(hashes[slot]);
+    ShaderUniformDef* def = (val != mShaderUniformsInfo.end()) ? val->second : nullptr;
+    m_uniformSlots[slot] = def ? s32(def - m_ShaderUniforms) : -1;
+    return def;
 }
\ No newline at end of file
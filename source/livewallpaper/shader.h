@@ -1,9 +1,12 @@
 #pragma once
 #include <unordered_map>
+#include <vector>
 #include <string>
+#include <string.h>
 #include <GLES3/gl3.h>
 #include <EGL/egl.h>
 #include <core/types.h>
+#include <core/string_hash.h>
 #include <math/vector2d.h>
 #include <math/vector3d.h>
 #include <math/vector4d.h>
@@ -17,8 +20,23 @@ struct ShaderUniformDef
 	int		location;
 	int		arraySize;
 	GLenum	valueType;
+	//! last value set, in m_uniformShadow, invalid until the first set
+	u32		shadowOffset;
+	u32		shadowSize;
+	bool	shadowValid;
 };
 
+//! Dense index of a uniform name, the same in every program.
+typedef u32 UniformSlot;
+
+//! Slot of the name, new names get the next free one. Call it through
+//! SHADER_UNIFORM so it runs once per call site.
+UniformSlot registerUniformSlot(size_t hashedName, const char* name);
+
+//! Slot of a uniform name literal, hashed at compile time and registered the
+//! first time the call site runs. Only the render thread sets uniforms.
+#define SHADER_UNIFORM(name) ([]() -> UniformSlot { static const UniformSlot slot = registerUniformSlot(CTHASH(name), name); return slot; }())
+
 struct ShaderAttributeDef
 {
     E_Vertex_Attribute  attributeType;
@@ -28,62 +46,141 @@ struct ShaderAttributeDef
 class Shader
 {
 public:
-    Shader(const char* verStr, const char* fragStr);
+    //! Loads the program from the ShaderCache when it has it, otherwise
+    //! compiles and links it. With deferLink the link is only started, the
+    //! program is usable once poll() returns true.
+    Shader(const char* verStr, const char* fragStr, bool deferLink = false);
     ~Shader();
 
+    //! True once the link finished, successful or not. Never blocks while the
+    //! driver links in the background through GL_KHR_parallel_shader_compile,
+    //! without it the first call waits for the link.
+    bool	poll();
+    bool	isLinked() const;
+
 	void bind() const;
 	void unbind() const;
 
-	GLint	getUniformLocation( size_t hashedName );
+	GLint	getUniformLocation( UniformSlot slot );
 
     typedef const ShaderAttributeDef* VertexAttributeIter;
 
     VertexAttributeIter getVertexAttributesBegin() const;
     VertexAttributeIter getVertexAttributesEnd() const;
 
-	void	uniform( size_t name, int data );	
-	void	uniform( size_t name, float data );
-	void	uniform( size_t name, const vector2df &data );
-	void	uniform( size_t name, const vector3df &data );
-	void	uniform( size_t name, const vector4df &data );
-	void	uniform( size_t name, const matrix3 &data, bool transpose = false );
-	void	uniform( size_t name, const matrix4 &data, bool transpose = false );
-	void	uniform( size_t name, const float *data, int count );
-	void	uniform( size_t name, const vector2df *data, int count );
-	void	uniform( size_t name, const vector3df *data, int count );
-	void	uniform( size_t name, const vector4df *data, int count );
-	void	uniform( size_t name, const matrix3 *data, int count, bool transpose = false );
-	void	uniform( size_t name, const matrix4 *data, int count, bool transpose = false );
+    //! E_VERTEX_ATTRIBUTE_BITS of the attributes the shader reads.
+    u32 getVertexAttributeMask() const;
+
+    //! Equal for shaders reading the same attributes at the same locations,
+    //! they can draw from the same vertex arrays.
+    u64 getVertexAttributeLayoutKey() const;
+
+	//! The program must be bound. Values equal to the last one set skip the
+	//! gl call.
+	void	uniform( UniformSlot slot, int data );
+	void	uniform( UniformSlot slot, float data );
+	void	uniform( UniformSlot slot, const vector2df &data );
+	void	uniform( UniformSlot slot, const vector3df &data );
+	void	uniform( UniformSlot slot, const vector4df &data );
+	void	uniform( UniformSlot slot, const matrix3 &data, bool transpose = false );
+	void	uniform( UniformSlot slot, const matrix4 &data, bool transpose = false );
+	void	uniform( UniformSlot slot, const float *data, int count );
+	void	uniform( UniformSlot slot, const vector2df *data, int count );
+	void	uniform( UniformSlot slot, const vector3df *data, int count );
+	void	uniform( UniformSlot slot, const vector4df *data, int count );
+	void	uniform( UniformSlot slot, const matrix3 *data, int count, bool transpose = false );
+	void	uniform( UniformSlot slot, const matrix4 *data, int count, bool transpose = false );
 
 private:
     GLuint	loadShader ( GLenum type, const char *shaderStr);
+    void	finishLink();
     void	generateShaderInfo( GLuint shaderProgram);
 
+    //! Uniform of the slot in this program, null when the program lacks it.
+    ShaderUniformDef*	findUniform( UniformSlot slot );
+    ShaderUniformDef*	resolveUniform( UniformSlot slot );
+    //! Uniform to upload size bytes of data to, null when the program lacks
+    //! it or already holds the value. Null data always uploads and forgets
+    //! the shadow.
+    const ShaderUniformDef*	changedUniform( UniformSlot slot, const void* data, u32 size );
+
 private:
     GLuint				    mShaderProgram;
+    //compiled shaders of a link still in progress
+    GLuint                  m_vertexShader;
+    GLuint                  m_fragmentShader;
+    bool                    m_linkPending;
+    u64                     m_cacheKey;
     ShaderAttributeDef*     m_ShaderAttributes;
     u32                     m_ShaderAttributesNum;
+    u32                     m_vertexAttributeMask;
+    u64                     m_vertexAttributeLayoutKey;
+    ShaderUniformDef*       m_ShaderUniforms;
 	std::unordered_map<size_t, ShaderUniformDef*> mShaderUniformsInfo;
+	//! uniform index per slot, -1 when the program lacks it, -2 unresolved
+	std::vector<s32>        m_uniformSlots;
+	std::vector<u8>         m_uniformShadow;
 };
 
 
 inline void 
 Shader::bind() const
 {
+	JENNY_ASSERT(!m_linkPending);
 	glUseProgram(mShaderProgram);
 }
 
+inline bool
+Shader::isLinked() const
+{
+	return mShaderProgram && !m_linkPending;
+}
+
 inline void 
 Shader::unbind() const
 {
 	//glUseProgram(0);
 }
 
+inline ShaderUniformDef*
+Shader::findUniform( UniformSlot slot )
+{
+	s32 index = (slot < m_uniformSlots.size()) ? m_uniformSlots[slot] : -2;
+	if (index == -2)
+		return resolveUniform(slot);
+	return (index >= 0) ? &m_ShaderUniforms[index] : nullptr;
+}
+
 inline GLint 
-Shader::getUniformLocation( size_t hashedName )
+Shader::getUniformLocation( UniformSlot slot )
 {
-	auto val = mShaderUniformsInfo.find(hashedName);
-	return (val != mShaderUniformsInfo.end() ? val->second->location : -1);
+	const ShaderUniformDef* def = findUniform(slot);
+	return def ? def->location : -1;
+}
+
+inline const ShaderUniformDef*
+Shader::changedUniform( UniformSlot slot, const void* data, u32 size )
+{
+	ShaderUniformDef* def = findUniform(slot);
+	if (!def || def->location < 0)
+		return nullptr;
+
+	if (!data)
+	{
+		def->shadowValid = false;
+		return def;
+	}
+
+	//arrays set partially compare their first elements only
+	u8* shadow = &m_uniformShadow[def->shadowOffset];
+	if (size > def->shadowSize)
+		size = def->shadowSize;
+	if (def->shadowValid && memcmp(shadow, data, size) == 0)
+		return nullptr;
+
+	memcpy(shadow, data, size);
+	def->shadowValid = true;
+	return def;
 }
 
 
@@ -100,108 +197,122 @@ Shader::getVertexAttributesEnd() const
     return (m_ShaderAttributes + m_ShaderAttributesNum);
 }
 
+inline u32
+Shader::getVertexAttributeMask() const
+{
+    return m_vertexAttributeMask;
+}
+
+inline u64
+Shader::getVertexAttributeLayoutKey() const
+{
+    return m_vertexAttributeLayoutKey;
+}
+
 
 inline void	
-Shader::uniform( size_t name, int data )
+Shader::uniform( UniformSlot slot, int data )
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniform1i(loc, data);
+	const ShaderUniformDef* def = changedUniform(slot, &data, sizeof(data));
+	if(def)
+		glUniform1i(def->location, data);
 }
 
 
 inline void	
-Shader::uniform( size_t name, float data )
+Shader::uniform( UniformSlot slot, float data )
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniform1f(loc,data);
+	const ShaderUniformDef* def = changedUniform(slot, &data, sizeof(data));
+	if(def)
+		glUniform1f(def->location, data);
 }
 
 inline void	
-Shader::uniform( size_t name, const vector2df &data )
+Shader::uniform( UniformSlot slot, const vector2df &data )
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniform2f(loc, data.x(), data.y());
+	const ShaderUniformDef* def = changedUniform(slot, data.getDataPtr(), sizeof(f32)*2);
+	if(def)
+		glUniform2f(def->location, data.x(), data.y());
 }
 
 inline void	
-Shader::uniform( size_t name, const vector3df &data )
+Shader::uniform( UniformSlot slot, const vector3df &data )
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniform3f(loc,data.x(), data.y(), data.z());
+	const ShaderUniformDef* def = changedUniform(slot, data.getDataPtr(), sizeof(f32)*3);
+	if(def)
+		glUniform3f(def->location, data.x(), data.y(), data.z());
 }
 
 inline void	
-Shader::uniform( size_t name, const vector4df &data )
+Shader::uniform( UniformSlot slot, const vector4df &data )
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniform4f(loc, data.x(), data.y(), data.z(), data.w());
+	const ShaderUniformDef* def = changedUniform(slot, data.getDataPtr(), sizeof(f32)*4);
+	if(def)
+		glUniform4f(def->location, data.x(), data.y(), data.z(), data.w());
 }
 
+//transposed uploads bypass the shadow, it holds values as given
+
 inline void	
-Shader::uniform( size_t name, const matrix3 &data, bool transpose)
+Shader::uniform( UniformSlot slot, const matrix3 &data, bool transpose)
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniformMatrix3fv(loc,1,(transpose) ? GL_TRUE:GL_FALSE, data.pointer());
+	const ShaderUniformDef* def = changedUniform(slot, transpose ? nullptr : data.pointer(), sizeof(f32)*9);
+	if(def)
+		glUniformMatrix3fv(def->location, 1, (transpose) ? GL_TRUE : GL_FALSE, data.pointer());
 }
 
 inline void	
-Shader::uniform( size_t name, const matrix4 &data, bool transpose)
+Shader::uniform( UniformSlot slot, const matrix4 &data, bool transpose)
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniformMatrix4fv(loc,1, (transpose) ? GL_TRUE : GL_FALSE, data.pointer());
+	const ShaderUniformDef* def = changedUniform(slot, transpose ? nullptr : data.pointer(), sizeof(f32)*16);
+	if(def)
+		glUniformMatrix4fv(def->location, 1, (transpose) ? GL_TRUE : GL_FALSE, data.pointer());
 }
 
 inline void	
-Shader::uniform( size_t name, const float *data, int count )
+Shader::uniform( UniformSlot slot, const float *data, int count )
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniform1fv(loc, count, data);
+	const ShaderUniformDef* def = changedUniform(slot, data, sizeof(f32)*count);
+	if(def)
+		glUniform1fv(def->location, count, data);
 }
 
 inline void	
-Shader::uniform( size_t name, const vector2df *data, int count )
+Shader::uniform( UniformSlot slot, const vector2df *data, int count )
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniform2fv(loc, count, data->getDataPtr());
+	const ShaderUniformDef* def = changedUniform(slot, data->getDataPtr(), sizeof(f32)*2*count);
+	if(def)
+		glUniform2fv(def->location, count, data->getDataPtr());
 }
 
 inline void	
-Shader::uniform( size_t name, const vector3df *data, int count )
+Shader::uniform( UniformSlot slot, const vector3df *data, int count )
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniform3fv(loc, count, data->getDataPtr());
+	const ShaderUniformDef* def = changedUniform(slot, data->getDataPtr(), sizeof(f32)*3*count);
+	if(def)
+		glUniform3fv(def->location, count, data->getDataPtr());
 }
 
 inline void	
-Shader::uniform( size_t name, const vector4df *data, int count )
+Shader::uniform( UniformSlot slot, const vector4df *data, int count )
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniform4fv(loc, count, data->getDataPtr());
+	const ShaderUniformDef* def = changedUniform(slot, data->getDataPtr(), sizeof(f32)*4*count);
+	if(def)
+		glUniform4fv(def->location, count, data->getDataPtr());
 }
 
 inline void	
-Shader::uniform( size_t name, const matrix3 *data, int count, bool transpose)
+Shader::uniform( UniformSlot slot, const matrix3 *data, int count, bool transpose)
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniformMatrix3fv(loc,count, (transpose) ? GL_TRUE : GL_FALSE, data->pointer());
+	const ShaderUniformDef* def = changedUniform(slot, transpose ? nullptr : data->pointer(), sizeof(f32)*9*count);
+	if(def)
+		glUniformMatrix3fv(def->location, count, (transpose) ? GL_TRUE : GL_FALSE, data->pointer());
 }
 
 inline void	
-Shader::uniform( size_t name, const matrix4 *data, int count, bool transpose)
+Shader::uniform( UniformSlot slot, const matrix4 *data, int count, bool transpose)
 {
-	GLint loc = getUniformLocation(name);
-	if(loc >= 0)
-		glUniformMatrix4fv( loc, count, ( transpose ) ? GL_TRUE : GL_FALSE, data->pointer());
+	const ShaderUniformDef* def = changedUniform(slot, transpose ? nullptr : data->pointer(), sizeof(f32)*16*count);
+	if(def)
+		glUniformMatrix4fv(def->location, count, (transpose) ? GL_TRUE : GL_FALSE, data->pointer());
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "texture2d.h"
 #include "framebuffer.h"
 #include <string>
+#include <string.h>
 #include "shader.h"
 #include <core/string_hash.h>
 #include <math/math.h>
@@ -14,7 +15,14 @@
 #include <math/matrix3.h>
 #include <math/matrix4.h>
 #include <math/quaternion.h>
-#include "esutils.h"
+#include "RippleSimulation.h"
+#include "WaterSimulationThread.h"
+#include "StreamingBuffer.h"
+#include "GridMesh.h"
+#include "GpuRippleSimulation.h"
+#include <core/Clock.h>
+#include <core/Profiler.h>
+#include "GpuProfiler.h"
 
 using namespace jenny;
 
@@ -22,12 +30,17 @@ using namespace jenny;
 
 vector2di getSceenDPI()
 {
+#if defined(_WIN32)
 	HDC screen = GetDC(0);
 	int dpiX = GetDeviceCaps (screen, LOGPIXELSX);
 	int dpiY = GetDeviceCaps (screen, LOGPIXELSY);
 	ReleaseDC (0, screen);
 
 	return vector2di(dpiX, dpiY);
+#else
+	//headless, no screen to ask
+	return vector2di(96, 96);
+#endif
 }
 
 Water::Water(int screenWidth, int screenHeight, float dx):	m_screenWidth(screenWidth)
@@ -38,6 +51,9 @@ Water::Water(int screenWidth, int screenHeight, float dx):	m_screenWidth(screenW
 	,m_vertexBuffer(NULL)
 	,m_indexBuffer(NULL)
 	,m_textureObject(NULL)
+	,m_waterMesh_UV(nullptr)
+	,m_waterGrid(nullptr)
+	,m_waterLod(0)
 	,m_positionIndex(-1)
 	,m_uvIndex(-1)
 	,m_heightMapIndex(-1)
@@ -47,26 +63,86 @@ Water::Water(int screenWidth, int screenHeight, float dx):	m_screenWidth(screenW
 	,m_fbWrite(nullptr)
 	,m_fbRead(nullptr)
 	,m_frameBufferCaustic(nullptr)
+	,m_quadShader(nullptr)
 	,m_shader_drop(nullptr)
 	,m_shader_update(nullptr)
+	,m_shader_normal(nullptr)
 	,m_shader_water(nullptr)
 	,m_shader_caustics(nullptr)
 	,m_shader_waterMesh(nullptr)
 	,m_shader_init(nullptr)
 	,m_shader_water_uv(nullptr)
+	,m_shader_water_height(nullptr)
+	,m_simulation(nullptr)
+	,m_simulationThread(nullptr)
+	,m_uvStream(nullptr)
+	,m_uvOffset(0)
+	,m_surfaceChanged(true)
+	,m_uniformBlocks(nullptr)
+	,m_uniformBlocksWritten(false)
+	,m_touchStamp(nullptr)
+	,m_strokeOpen(false)
+	,m_strokeX(0)
+	,m_strokeY(0)
+	,m_gpuSimulation(nullptr)
+	,m_gpuNextStep(0)
 {
 }
 
 Water::~Water()
 {
+	this->_releaseWaterMeshUV();
+	delete m_uniformBlocks;
+	delete m_gpuSimulation;
+	delete m_simulationThread;
+	delete m_simulation;
+}
 
+const char* getWaterBackendName(E_Water_Backend backend)
+{
+	switch (backend)
+	{
+	case EWB_CPU:		return "cpu";
+	case EWB_GPU:		return "gpu";
+	default:			return "unknown";
+	}
 }
 
-void Water::Init()
+//derived grid limits, the upper one is the largest the index paths are sized for
+static const int MIN_GRID_SIZE = 16;
+static const int MAX_GRID_SIZE = 2048;
+
+//one cell per few screen pixels, so high density screens get a finer grid
+static int deriveGridSize(int screenSize, int cellSize)
+{
+	return std::min(std::max(screenSize/std::max(cellSize, 1), MIN_GRID_SIZE), MAX_GRID_SIZE);
+}
+
+//GL element type of the offsets in a uv format
+static GLenum getUVFormatGLType(E_UV_Format format)
+{
+	switch (format)
+	{
+	case EUF_INT16:		return GL_SHORT;
+	case EUF_INT8:		return GL_BYTE;
+	default:			return GL_FLOAT;
+	}
+}
+
+void Water::Init(const WaterSettings& settings)
 {
 	const GLubyte* extension = glGetString(GL_EXTENSIONS);
 
+	m_settings = settings;
+
+	if (m_settings.gridWidth <= 0)
+		m_settings.gridWidth = deriveGridSize(m_screenWidth, m_settings.cellSize);
+	if (m_settings.gridHeight <= 0)
+		m_settings.gridHeight = deriveGridSize(m_screenHeight, m_settings.cellSize);
+
 	this->_initShader();
+	if (esGetContextMajorVersion() >= 3)
+		m_uniformBlocks = new UniformBlocks(EWP_COUNT);
 	//this->_initMesh();
 	this->_initWaterMeshUV();
 	this->_initTexture();
@@ -80,12 +156,26 @@ void Water::Init()
 	//this->_initFrameBuffers();
 
 	m_screenScaleX = m_screenWidth*1.0f/m_screenHeight;
+
+	if (m_simulationThread && m_settings.simulationThread)
+		m_simulationThread->Start();
 }
 
 
 void Water::Update()
 {
-	this->_updateWaterMeshUV();
+	PROFILE_SCOPE("Water::Update");
+
+	if (m_gpuSimulation)
+	{
+		this->_stepGpuSimulation();
+	}
+	else if (!m_simulationThread->IsRunning())
+	{
+		//step straight into the mapped vertex buffer, no staging copy
+		RowRange stepRows = m_simulationThread->ApplyDrops();
+		this->_uploadWaterMeshUV(stepRows, nullptr);
+	}
 
 #if 1
 	//this->_doUpdate();
@@ -95,9 +185,22 @@ void Water::Update()
 #endif
 }
 
+bool Water::UpdateSurface()
+{
+	this->_updateWaterMeshUV();
+	return m_surfaceChanged;
+}
+
 void Water::Render()
 {
 	this->_drawWaterMeshUV();
+	m_surfaceChanged = false;
+
+	if (m_uniformBlocksWritten)
+	{
+		m_uniformBlocks->Fence();
+		m_uniformBlocksWritten = false;
+	}
 #if 0
 	//_drawQuad();
 #else
@@ -115,10 +218,10 @@ void Water::_processTouch(int x, int y)
 	m_fbWrite->Begin();
 	m_shader_drop->bind();
 	vector2df vec2(float(x)/m_screenWidth,float(y)/m_screenHeight);
-	m_shader_drop->uniform(RTHASH("center"), vec2);
-	m_shader_drop->uniform(RTHASH("radius"), radius);
-	m_shader_drop->uniform(RTHASH("strength"), strength);
-	m_shader_drop->uniform(RTHASH("scaleX"), m_screenScaleX);
+	m_shader_drop->uniform(SHADER_UNIFORM("center"), vec2);
+	m_shader_drop->uniform(SHADER_UNIFORM("radius"), radius);
+	m_shader_drop->uniform(SHADER_UNIFORM("strength"), strength);
+	m_shader_drop->uniform(SHADER_UNIFORM("scaleX"), m_screenScaleX);
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D,m_fbRead->GetColorTexture());
 	_renderMesh(m_screenRect,m_shader_drop);
@@ -137,7 +240,7 @@ void Water::_initShader()
 		#include "VertexShader_Quad.h"
 		const char* strFragmentShader = 
 		#include "FragmentShader_Quad.h"
-		m_quadShader = new Shader(strVertexShader, strFragmentShader);
+		m_quadShader = new Shader(strVertexShader, strFragmentShader, true);
 	}
 
 	//init shader
@@ -146,7 +249,7 @@ void Water::_initShader()
 		#include "VertexShader_Common.h"
 		const char* strFragmentShader = 
 		#include "FragmentShader_Init.h"
-		m_shader_init = new Shader(strVertexShader, strFragmentShader);
+		m_shader_init = new Shader(strVertexShader, strFragmentShader, true);
 	}
 
 	//drop shader 
@@ -155,7 +258,7 @@ void Water::_initShader()
 		#include "VertexShader_Common.h"
 		const char* fragmentShader = 
 		#include "FragmentShader_Drop.h"
-		m_shader_drop = new Shader(vertexShader,fragmentShader);
+		m_shader_drop = new Shader(vertexShader,fragmentShader, true);
 	}
 
 	//update shader
@@ -164,7 +267,7 @@ void Water::_initShader()
 		#include "VertexShader_Common.h"
 		const char* strFragmentShader = 
 		#include "FragmentShader_Update.h"
-		m_shader_update = new Shader(strVertexShader,strFragmentShader);
+		m_shader_update = new Shader(strVertexShader,strFragmentShader, true);
 	}
 
 	//normal shader
@@ -174,36 +277,43 @@ void Water::_initShader()
 		#include "VertexShader_Common.h"
 		const char* strFragmentShader_normal = 
 		#include "FragmentShader_Normal.h"
-		m_shader_normal = new Shader(strVertexShader, strFragmentShader_normal);
+		m_shader_normal = new Shader(strVertexShader, strFragmentShader_normal, true);
 	}
 #endif
 
+	//the water, caustic and water mesh shaders read the uniform blocks and
+	//are 300 es, an es 2 context can not compile them
+	bool es3 = esGetContextMajorVersion() >= 3;
+
 	//water shader
+	if (es3)
 	{
 		const char* strVertexShader = 
 		#include "VertexShader_Water.h"
 		const char* strFragmentShader =
 		#include "FragmentShader_Water.h"
-		m_shader_water = new Shader(strVertexShader, strFragmentShader);
+		m_shader_water = new Shader(strVertexShader, strFragmentShader, true);
 	}
 
 	//caustic shader
 #if 0
+	if (es3)
 	{
 		const char* strVertexShader =
 		#include "VertexShader_Caustic.h"
 		const char* strFragmentShader =
 		#include "FragmentShader_Caustic.h"
-		m_shader_caustics = new Shader(strVertexShader,strFragmentShader); 
+		m_shader_caustics = new Shader(strVertexShader,strFragmentShader, true); 
 	}
 
 	//water mesh
+	if (es3)
 	{
 		const char* strVertexShader =
 		#include "VertexShader_WaterMesh.h"
 		const char* strFragmentShader =
 		#include "FragmentShader_WaterMesh.h"
-		m_shader_waterMesh = new Shader(strVertexShader, strFragmentShader);
+		m_shader_waterMesh = new Shader(strVertexShader, strFragmentShader, true);
 	}
 #endif
 
@@ -213,8 +323,41 @@ void Water::_initShader()
 		#include "VertexShader_Water_UV.h"
 		const char* strFragmentShader =
 		#include "FragmentShader_Water_UV.h"
-		m_shader_water_uv = new Shader(strVertexShader, strFragmentShader);
+		m_shader_water_uv = new Shader(strVertexShader, strFragmentShader, true);
+	}
+
+	//water mesh displaced by the gpu solver
+	{
+		const char* strVertexShader =
+		#include "VertexShader_Water_Height.h"
+		const char* strFragmentShader =
+		#include "FragmentShader_Water_UV.h"
+		m_shader_water_height = new Shader(strVertexShader, strFragmentShader, true);
+	}
+
+	//every link was started before waiting for any, they run side by side
+	Shader* shaders[] = {m_quadShader, m_shader_init, m_shader_drop, m_shader_update, m_shader_normal,
+		m_shader_water, m_shader_caustics, m_shader_waterMesh, m_shader_water_uv, m_shader_water_height};
+	for (size_t i=0; i<sizeof(shaders)/sizeof(shaders[0]); ++i)
+	{
+		if (shaders[i])
+			m_pendingShaders.push_back(shaders[i]);
+	}
+}
+
+bool Water::IsReady()
+{
+	for (size_t i=0; i<m_pendingShaders.size(); )
+	{
+		if (m_pendingShaders[i]->poll())
+		{
+			m_pendingShaders[i] = m_pendingShaders.back();
+			m_pendingShaders.pop_back();
+		}
+		else
+			++i;
 	}
+	return m_pendingShaders.empty();
 }
 
 void Water::_initTexture()
@@ -276,34 +419,14 @@ void Water::_initMesh()
 		}
 
 
-		int numFaces = (resWidth-1)*(resHeight-1)*2;
-		std::vector<GLushort> indices(numFaces*3);
-		int k = 0;
-		for (int y=0; y<resHeight-1; ++y)
-		{
-			for(int x=0; x<resWidth-1; ++x)
-			{
-				indices[k++] = y*resWidth + x;
-				indices[k++] = y*resWidth + x + 1;
-				indices[k++] = (y + 1)*resWidth + x;
-
-				indices[k++] = (y + 1)*resWidth + x;
-				indices[k++] = y*resWidth + x + 1;
-				indices[k++] = (y + 1)*resWidth + x + 1;
-			}
-		}
-
 		glGenBuffers(1,&m_vertexBuffer);
 		glBindBuffer(GL_ARRAY_BUFFER,m_vertexBuffer);
 		glBufferData(GL_ARRAY_BUFFER,sizeof(vector3df)*resWidth*resHeight, vertexBuffer,GL_STATIC_DRAW);
 
-		glGenBuffers(1,&m_indexBuffer);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_indexBuffer);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(GLushort)*numFaces*3,&indices[0],GL_STATIC_DRAW);
-
-		m_waterMesh = new MeshObject(m_vertexBuffer,m_indexBuffer);
+		GridMesh grid(resWidth, resHeight, m_settings.mesh);
+		m_waterMesh = grid.CreateMesh(m_vertexBuffer);
 		m_waterMesh->addMeshAttribute("position",3,GL_FLOAT,sizeof(vector3df),0);
-		m_waterMesh->setIndexCount(numFaces*3);
+		m_indexBuffer = m_waterMesh->getIBO();
 
 		delete[] vertexBuffer;
 	}
@@ -375,9 +498,9 @@ void Water::_drawQuad()
 	kmVec2 vec2;
 	vec2.x = 0.5f;
 	vec2.y = 0.5f;
-	m_shader_drop->uniform(RTHASH("center"), vec2);
-	m_shader_drop->uniform(RTHASH("radius"), radius);
-	m_shader_drop->uniform(RTHASH("strength"), strength);
+	m_shader_drop->uniform(SHADER_UNIFORM("center"), vec2);
+	m_shader_drop->uniform(SHADER_UNIFORM("radius"), radius);
+	m_shader_drop->uniform(SHADER_UNIFORM("strength"), strength);
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D,m_frameBufferB->GetColorTexture());
 	glBindTexture(GL_TEXTURE_2D,m_textureObject);
@@ -392,7 +515,7 @@ void Water::_drawQuad()
 	glActiveTexture(GL_TEXTURE0);
 	//glBindTexture(GL_TEXTURE_2D, m_frameBufferB->GetColorTexture());
 	glBindTexture(GL_TEXTURE_2D, m_textureObject);
-	m_quadShader->uniform(RTHASH("s_texture"), 0);
+	m_quadShader->uniform(SHADER_UNIFORM("s_texture"), 0);
 	_renderMesh(m_screenRect,m_quadShader);
 	m_quadShader->unbind();
 	glGetError();
@@ -413,16 +536,11 @@ void Water::_drawQuad()
 	//	g_viewProjectMatrix.transformVect(transformedVertexs[i],originalVertex[i]);
 	//}
 
-	matrix4 transposedMatrix = g_viewProjectMatrix.getTransposed();
-	vector2df screenSize((float)m_screenWidth, (float)m_screenHeight);
-	//vector2df screenSize(10.0f, 10.0f);
-
-	//
-	static const float inverseWidth = 1.0f/m_fbWrite->GetWidth();
-	static const float inverseHeight = 1.0f/m_fbWrite->GetHeight();
-	//
+	if (!m_shader_water)
+		return;
 
 	glViewport(0, 0, m_screenWidth, m_screenHeight); 
+	this->_bindPassUniforms(EWP_WATER_QUAD);
 	m_shader_water->bind();
 	glActiveTexture(GL_TEXTURE0);
 #if 1
@@ -430,24 +548,14 @@ void Water::_drawQuad()
 #else
 	glBindTexture(GL_TEXTURE_2D, m_frameBufferCaustic->GetColorTexture());
 #endif
-	m_shader_water->uniform(RTHASH("water"),0);
+	m_shader_water->uniform(SHADER_UNIFORM("water"),0);
 
 #if 0
 	glActiveTexture(GL_TEXTURE1);
 	glBindTexture(GL_TEXTURE_2D, m_textureObject);
-	m_shader_water->uniform(RTHASH("base"),1);
+	m_shader_water->uniform(SHADER_UNIFORM("base"),1);
 #endif
 
-	m_shader_water->uniform(RTHASH("screenSize"), screenSize);
-
-#if 1
-	m_shader_water->uniform(RTHASH("WVPMatrix"), g_viewProjectMatrixOrc);
-#else
-	m_shader_water->uniform(RTHASH("WVPMatrix"), g_viewProjectMatrix);
-#endif
-	vector2df delta(inverseWidth, inverseHeight);
-	m_shader_water->uniform(RTHASH("delta"), delta);
-
 	_renderMesh(m_screenRect,m_shader_water);
 	m_shader_water->unbind();
 	glGetError();
@@ -457,43 +565,7 @@ void Water::_drawQuad()
 
 void Water::_renderMesh(const MeshObject* mesh, const Shader* shader)
 {
-    GLuint vbo = mesh->getVBO();
-    GLuint ibo = mesh->getIBO();
-
-    glBindBuffer(GL_ARRAY_BUFFER,vbo);
-
-    for (auto it = shader->getVertexAttributesBegin(); 
-        it != shader->getVertexAttributesEnd(); 
-        ++it)
-    {
-
-        E_Vertex_Attribute attribute = it->attributeType;
-        s32  attributesLoc = it->location;
-        const MeshAttributeDef* meshAttribute = mesh->getMeshAttribute(attribute);
-
-        glVertexAttribPointer(attributesLoc,
-                              meshAttribute->m_elementNum,
-                              meshAttribute->m_elementType,
-                              0,
-                              meshAttribute->m_stride, 
-                              reinterpret_cast<u32*>(meshAttribute->m_offset)
-                              );
-
-        glEnableVertexAttribArray(attributesLoc);
-    }
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,ibo);
-    glDrawElements(GL_TRIANGLES, 
-                   mesh->getIndexCount(),
-                   GL_UNSIGNED_SHORT,
-                   NULL);
-
-    for (auto it = shader->getVertexAttributesBegin(); 
-        it != shader->getVertexAttributesEnd(); 
-        ++it)
-    {
-        glDisableVertexAttribArray(it->location);
-    }
+    mesh->draw(shader);
 }
 
 void Water::_doUpdate()
@@ -507,10 +579,10 @@ void Water::_doUpdate()
 	vector2df delta(inverseWidth, m_screenScaleX*inverseHeight);
 	//delta.x = inverseWidth;
 	//delta.y = m_screenScaleX*inverseHeight;
-	m_shader_update->uniform(RTHASH("delta"), delta);
+	m_shader_update->uniform(SHADER_UNIFORM("delta"), delta);
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D,m_fbRead->GetColorTexture());
-	m_shader_update->uniform(RTHASH("texture"), 0);
+	m_shader_update->uniform(SHADER_UNIFORM("texture"), 0);
 	_renderMesh(m_screenRect,m_shader_update);
 	m_shader_update->unbind();
 	m_fbWrite->End();
@@ -529,7 +601,7 @@ void Water::_updateNormal()
 	vector2df delta(inverseWidth, inverseHeight);
 	//delta.x = inverseWidth;
 	//delta.y = inverseHeight;
-	m_shader_normal->uniform(RTHASH("delta"), delta);
+	m_shader_normal->uniform(SHADER_UNIFORM("delta"), delta);
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D,m_fbRead->GetColorTexture());
 	_renderMesh(m_screenRect,m_shader_normal);
@@ -541,20 +613,15 @@ void Water::_updateNormal()
 
 void Water::_genCaustics()
 {
+	if (!m_shader_caustics)
+		return;
+
 	glViewport(0, 0, m_frameBufferCaustic->GetWidth(), m_frameBufferCaustic->GetHeight());
 	m_frameBufferCaustic->Begin();
 	glClear ( GL_COLOR_BUFFER_BIT );
+	this->_bindPassUniforms(EWP_CAUSTICS);
 	m_shader_caustics->bind();
 
-	//uniform screensize
-	vector2df screenSize((float)m_screenWidth, (float)m_screenHeight);
-	m_shader_caustics->uniform(RTHASH("screenSize"), screenSize);
-
-	//uniform light dir
-	vector3df light(2.0f, -1.0f, 2.0f); //light(0.5f, 0.0f, 1.0f);
-	light.normalize();
-	m_shader_caustics->uniform(RTHASH("light"), light);
-
 	//uniform texture
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D,m_fbRead->GetColorTexture());
@@ -568,26 +635,53 @@ void Water::_genCaustics()
 
 void Water::_drawWaterMesh()
 {
+	if (!m_shader_waterMesh)
+		return;
+
 	glViewport(0, 0, m_screenWidth, m_screenHeight); 
+	this->_bindPassUniforms(EWP_WATER_MESH);
 	m_shader_waterMesh ->bind();
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, m_fbRead->GetColorTexture());
 
-	vector2df screenSize((float)m_screenWidth, (float)m_screenHeight);
-	m_shader_waterMesh->uniform(RTHASH("screenSize"), screenSize);
+	_renderMesh(m_waterMesh,m_shader_waterMesh);
+	m_shader_waterMesh->unbind();
+	glGetError();
+}
+
+void Water::_bindPassUniforms(E_Water_Pass pass)
+{
+	if (!m_uniformBlocks)
+		return;
 
-	vector3df light(2.0f, -1.0f, 2.0f); //light(0.5f, 0.0f, 1.0f);
-	light.normalize();
-	m_shader_waterMesh->uniform(RTHASH("light"), light);
+	if (!m_uniformBlocksWritten)
+	{
+		FrameUniforms frame;
+		memset(&frame, 0, sizeof(frame));
 #if 1
-	m_shader_waterMesh->uniform(RTHASH("WVPMatrix"), g_viewProjectMatrixOrc);
+		memcpy(frame.viewProjection, g_viewProjectMatrixOrc.pointer(), sizeof(frame.viewProjection));
 #else
-	m_shader_waterMesh->uniform(RTHASH("WVPMatrix"), g_viewProjectMatrix);
+		memcpy(frame.viewProjection, g_viewProjectMatrix.pointer(), sizeof(frame.viewProjection));
 #endif
+		vector3df light(2.0f, -1.0f, 2.0f); //light(0.5f, 0.0f, 1.0f);
+		light.normalize();
+		memcpy(frame.light, light.getDataPtr(), sizeof(frame.light));
+		frame.screenSize[0] = (float)m_screenWidth;
+		frame.screenSize[1] = (float)m_screenHeight;
+
+		//every pass samples the height texture
+		PassUniforms passes[EWP_COUNT];
+		memset(passes, 0, sizeof(passes));
+		for (int i=0; i<EWP_COUNT; ++i)
+		{
+			passes[i].delta[0] = 1.0f/m_fbWrite->GetWidth();
+			passes[i].delta[1] = 1.0f/m_fbWrite->GetHeight();
+		}
 
-	_renderMesh(m_waterMesh,m_shader_waterMesh);
-	m_shader_waterMesh->unbind();
-	glGetError();
+		m_uniformBlocks->Update(frame, passes);
+		m_uniformBlocksWritten = true;
+	}
+	m_uniformBlocks->BindPass(pass);
 }
 
 void Water::_initFrameBuffers()
@@ -609,23 +703,49 @@ void Water::_initFrameBuffers()
 	m_fbWrite->End();
 }
 
-vector2df* m_pUVBufferRead = nullptr;
-vector2df* m_pUVBufferWrite = nullptr;
-
-int *m_pHightRead = nullptr;
-int *m_pHightWrite = nullptr;
+//depth of the drop a touch makes
+static const int TOUCH_DROP_DEPTH = 16;
 
-int resWidth = 256;
-int resHeight = 256;
+//enough segments for the cpu to run two frames ahead of the gpu
+static const int UV_STREAM_SEGMENTS = 3;
 
 void Water::_initWaterMeshUV()
 {
-	vector2df* vertexBuffer = new vector2df[resWidth*resHeight];
-	m_pUVBufferRead = new vector2df[resWidth*resHeight];
-	m_pUVBufferWrite = new vector2df[resWidth*resHeight];
+	const int resWidth = m_settings.gridWidth;
+	const int resHeight = m_settings.gridHeight;
+
+	if (m_settings.backend == EWB_GPU && !GpuRippleSimulation::IsSupported())
+	{
+		esLogMessage("gpu ripple simulation not supported, using the cpu\n");
+		m_settings.backend = EWB_CPU;
+	}
+
+	if (m_settings.backend == EWB_GPU)
+	{
+		m_gpuSimulation = new GpuRippleSimulation(resWidth, resHeight);
+		m_gpuNextStep = getTimeMicroseconds();
+		esLogMessage("ripple simulation: %dx%d on the gpu, %s heights\n", resWidth, resHeight,
+			m_gpuSimulation->IsFullPrecision() ? "float32" : "float16");
+	}
+	else
+	{
+		m_simulation = new RippleSimulation(resWidth, resHeight, m_settings.threadCount, m_settings.heightPrecision,
+			m_settings.uvFormat);
+		m_simulationThread = new WaterSimulationThread(m_simulation, m_settings.simulationRate);
+		esLogMessage("ripple simulation: %dx%d, %d threads, %s kernel, %s heights, %s uv offsets\n",
+			resWidth, resHeight, m_simulation->GetThreadCount(), getRippleKernelName(m_simulation->GetKernel()),
+			getRipplePrecisionName(m_simulation->GetPrecision()), getUVFormatName(m_simulation->GetUVFormat()));
+	}
 
-	m_pHightRead = new int[resWidth*resHeight];
-	m_pHightWrite = new int[resWidth*resHeight];
+	this->_createWaterMeshUV();
+}
+
+void Water::_createWaterMeshUV()
+{
+	const int resWidth = m_settings.gridWidth;
+	const int resHeight = m_settings.gridHeight;
+
+	vector2df* vertexBuffer = new vector2df[resWidth*resHeight];
 
 	float inverseWidth = 1.0f/(resWidth-1);
 	float inverseHeight = 1.0f/(resHeight-1);
@@ -636,223 +756,332 @@ void Water::_initWaterMeshUV()
 		{
 			float posX = x*inverseWidth;
 			vertexBuffer[y*resWidth + x].set((posX - 0.5f)*2.0f, (posY-0.5f)*2.0f);
-			m_pUVBufferRead[y*resWidth + x].set(posX, posY);
-			m_pUVBufferWrite[y*resWidth + x].set(posX, posY);
-
-			m_pHightRead[y*resWidth + x] = 0;
-			m_pHightWrite[y*resWidth + x] = 0;
 		}
 	}
 
 
-	int numFaces = (resWidth-1)*(resHeight-1)*2;
-	std::vector<GLushort> indices(numFaces*3);
-	int k = 0;
-	for (int y=0; y<resHeight-1; ++y)
+	glGenBuffers(1,&m_vertexBuffer_Pos);
+	glBindBuffer(GL_ARRAY_BUFFER,m_vertexBuffer_Pos);
+	glBufferData(GL_ARRAY_BUFFER,sizeof(vector2df)*resWidth*resHeight, vertexBuffer,GL_STATIC_DRAW);
+
+	m_waterGrid = new GridMesh(resWidth, resHeight, m_settings.mesh);
+	m_waterMesh_UV = m_waterGrid->CreateMesh(m_vertexBuffer_Pos);
+	m_indexBuffer_UV = m_waterMesh_UV->getIBO();
+	m_waterLod = std::min(m_waterLod, m_waterGrid->GetLevelCount() - 1);
+	m_waterGrid->SetLevel(m_waterMesh_UV, m_waterLod);
+	esLogMessage("water mesh: %d vertices, %s %s, %d draws, %d lods, ACMR %.3f (row-major %.3f)\n",
+		resWidth*resHeight, m_waterMesh_UV->getIndexType() == GL_UNSIGNED_INT ? "32 bit" : "16 bit",
+		getGridIndexOrderName(m_waterGrid->GetSettings().order),
+		m_waterMesh_UV->getChunkCount(), m_waterGrid->GetLevelCount(),
+		m_waterGrid->GetACMR(), m_waterGrid->GetRowMajorACMR());
+
+	m_waterMesh_UV->addMeshAttribute("position",2,GL_FLOAT,sizeof(vector2df),0);
+
+	//every segment starts out with the current waves, flat unless the grid
+	//was resampled, later uploads only rewrite rows that moved
+	if (m_simulation)
 	{
-		for(int x=0; x<resWidth-1; ++x)
+		E_UV_Format uvFormat = m_simulation->GetUVFormat();
+		int uvSize = getUVFormatSize(uvFormat);
+		m_uvStream = new StreamingBuffer(GL_ARRAY_BUFFER, uvSize*resWidth*resHeight, UV_STREAM_SEGMENTS);
+		m_uvSegmentRows.assign(UV_STREAM_SEGMENTS, m_simulation->GetActiveRows());
+		for (int i=0; i<UV_STREAM_SEGMENTS; ++i)
 		{
-			indices[k++] = y*resWidth + x;
-			indices[k++] = y*resWidth + x + 1;
-			indices[k++] = (y + 1)*resWidth + x;
-
-			indices[k++] = (y + 1)*resWidth + x;
-			indices[k++] = y*resWidth + x + 1;
-			indices[k++] = (y + 1)*resWidth + x + 1;
+			void* uvBuffer = m_uvStream->Map();
+			if (uvBuffer)
+			{
+				m_simulation->WriteUV(uvBuffer, RowRange(0, resHeight));
+				m_uvOffset = m_uvStream->Unmap();
+			}
 		}
+
+		//only the offsets are streamed, the shader adds them to the position
+		bool normalized = uvFormat != EUF_FLOAT;
+		m_waterMesh_UV->addMeshAttribute("coord",2,getUVFormatGLType(uvFormat),uvSize,0,normalized ? GL_TRUE : GL_FALSE);
 	}
 
-	glGenBuffers(1,&m_vertexBuffer_Pos);
-	glBindBuffer(GL_ARRAY_BUFFER,m_vertexBuffer_Pos);
-	glBufferData(GL_ARRAY_BUFFER,sizeof(vector2df)*resWidth*resHeight, vertexBuffer,GL_STATIC_DRAW);
+	delete[] vertexBuffer;
+}
 
-	glGenBuffers(1,&m_indexBuffer_UV);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_indexBuffer_UV);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(GLushort)*numFaces*3,&indices[0],GL_STATIC_DRAW);
+u64 Water::GetHeightChecksum() const
+{
+	return m_simulation ? m_simulation->GetHeightChecksum() : 0;
+}
 
-	glGenBuffers(1, &m_vertexBuffer_UV);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer_UV);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vector2df)*resWidth*resHeight, m_pUVBufferWrite, GL_DYNAMIC_DRAW);
+void Water::_releaseWaterMeshUV()
+{
+	//the mesh owns the position and index buffers
+	delete m_waterMesh_UV;
+	delete m_waterGrid;
+	delete m_uvStream;
+	m_waterMesh_UV = nullptr;
+	m_waterGrid = nullptr;
+	m_uvStream = nullptr;
+	m_vertexBuffer_Pos = 0;
+	m_indexBuffer_UV = 0;
+	m_surfaceChanged = true;
+}
 
-	m_waterMesh_UV = new MeshObject(m_vertexBuffer_Pos,m_indexBuffer_UV);
-	m_waterMesh_UV->addMeshAttribute("position",2,GL_FLOAT,sizeof(vector2df),0);
-	m_waterMesh_UV->addMeshAttribute("coord",2,GL_FLOAT,sizeof(vector2df),0);
-	m_waterMesh_UV->setIndexCount(numFaces*3);
+void Water::SetCellSize(int cellSize)
+{
+	int width = deriveGridSize(m_screenWidth, cellSize);
+	int height = deriveGridSize(m_screenHeight, cellSize);
+	m_settings.cellSize = cellSize;
+	if (!m_simulation || (width == m_settings.gridWidth && height == m_settings.gridHeight))
+		return;
+
+	//drops still queued land on the old grid and get resampled with it
+	bool running = m_simulationThread->IsRunning();
+	m_simulationThread->Stop();
+	m_simulationThread->ApplyDrops();
+
+	RippleSimulation* simulation = new RippleSimulation(width, height, m_settings.threadCount, m_settings.heightPrecision,
+		m_settings.uvFormat);
+	simulation->Resample(*m_simulation);
+	delete m_simulationThread;
+	delete m_simulation;
+	m_simulation = simulation;
+	m_simulationThread = new WaterSimulationThread(m_simulation, m_settings.simulationRate);
+
+	m_settings.gridWidth = width;
+	m_settings.gridHeight = height;
+
+	//the open stroke is in cells of the old grid
+	m_strokeOpen = false;
+
+	this->_releaseWaterMeshUV();
+	this->_createWaterMeshUV();
+
+	if (running)
+		m_simulationThread->Start();
+	esLogMessage("ripple simulation: resampled to %dx%d\n", width, height);
+}
 
-	delete[] vertexBuffer;
+void Water::SetSimulationRate(int stepsPerSecond)
+{
+	m_settings.simulationRate = stepsPerSecond;
+	if (m_simulationThread)
+		m_simulationThread->SetStepsPerSecond(stepsPerSecond);
 }
 
-int inline READBUFFER(int* buffer, int x, int y)
+bool Water::IsAtRest() const
 {
-	return (buffer[y*resWidth + x]);
+	if (m_gpuSimulation)
+		return m_gpuSimulation->IsAtRest();
+	if (!m_simulationThread)
+		return false;
+
+	//the last segment uploaded is the one drawn
+	return m_simulationThread->IsAtRest() && m_uvSegmentRows[m_uvStream->GetSegment()].isEmpty();
 }
 
-void inline SETBUFFER(int* buffer, int x, int y, int value)	
+float Water::GetSimulationLoad() const
 {
-	buffer[y*resWidth + x] = value;
+	if (!m_simulationThread || !m_simulationThread->IsRunning())
+		return 0.0f;
+	return m_simulationThread->GetLoad();
 }
 
-const float m_DampingFactor = 0.04f;
-void Water::_updateWaterMeshUV()
+void Water::SetMeshLod(int level)
 {
-	int i,j;
-	float value;
+	if (!m_waterGrid)
+		return;
 
-	for (j=2; j<resHeight - 2; j++)
-	{
-		for (i=2; i< resWidth - 2; i++)
-		{
-			value = (float)(
-				READBUFFER(m_pHightRead,i-2,j) +
-				READBUFFER(m_pHightRead,i+2,j) +
-				READBUFFER(m_pHightRead,i,j-2) +
-				READBUFFER(m_pHightRead,i,j+2) +
-				READBUFFER(m_pHightRead,i-1,j) +
-				READBUFFER(m_pHightRead,i+1,j) +
-				READBUFFER(m_pHightRead,i,j-1) +
-				READBUFFER(m_pHightRead,i,j+1) +
-				READBUFFER(m_pHightRead,i-1,j-1) +
-				READBUFFER(m_pHightRead,i+1,j-1) +
-				READBUFFER(m_pHightRead,i-1,j+1) +
-				READBUFFER(m_pHightRead,i+1,j+1));
-
-			value /= 6.0f;
-			value -= (float)READBUFFER(m_pHightWrite, i, j);
-			value -= (value*m_DampingFactor);
-
-			m_pHightWrite[j * resWidth + i] = (int)value;
-
-			if(int(value) != 0)
-			{
-				int a= 0;
-				a++;
-			}
-		}
-	}
+	level = std::min(std::max(level, 0), m_waterGrid->GetLevelCount() - 1);
+	if (level == m_waterLod)
+		return;
 
-	//swap data
-	std::swap(m_pHightRead, m_pHightWrite);
+	m_waterLod = level;
+	m_waterGrid->SetLevel(m_waterMesh_UV, m_waterLod);
+	m_surfaceChanged = true;
+}
 
+void Water::_updateWaterMeshUV()
+{
+	PROFILE_SCOPE("Water::_updateWaterMeshUV");
 
-	//generate uv offset
-	int xoff, yoff, cnt = 0;
+	//pick up the newest finished step, never waits for the simulation
+	if (!m_simulationThread || !m_simulationThread->AcquireUVBuffer())
+		return;
 
-	for (int j=0; j< resHeight; j++)
-	{
-		for (int i=0; i<resWidth; i++, cnt ++)
-		{
-			xoff = 0;
-			if(i > 0 && i < resWidth - 1)
-			{
-				xoff -= (m_pHightRead[cnt - 1]);
-				xoff += (m_pHightRead[cnt + 1]);
-			}
+	const WaterSimulationThread::UVFrame* frame = m_simulationThread->GetUVFrame();
+	this->_uploadWaterMeshUV(frame->activeRows, frame->uv);
+}
 
-			yoff = 0;
-			if(j>0 && j<resHeight - 1)
-			{
-				yoff -= m_pHightRead[cnt - resWidth];
-				yoff += m_pHightRead[cnt + resWidth];
-			}
+void Water::_uploadWaterMeshUV(const RowRange& activeRows, const u8* uvBuffer)
+{
+	PROFILE_SCOPE("Water::_uploadWaterMeshUV");
 
-			//one equals one pixel
-			const vector2df& oriUV = m_pUVBufferRead[cnt];
-			vector2df& newUV = m_pUVBufferWrite[cnt];
-			newUV.setX(xoff*0.5f/512.0f + oriUV.getX());
-			newUV.setY(yoff*0.5f/512.0f + oriUV.getY());
+	//flat water is already on screen
+	if (activeRows.isEmpty() && m_uvSegmentRows[m_uvStream->GetSegment()].isEmpty())
+		return;
 
-			if(xoff != 0)
-			{
-				int a = 0;
-				a++;
-			}
-		}
+	//the next segment is flat outside the rows it had last time
+	int segment = m_uvStream->GetNextSegment();
+	RowRange rows = activeRows.merged(m_uvSegmentRows[segment]);
+	if (rows.isEmpty())
+	{
+		//nothing to rewrite, but the flat segment still has to be the one drawn
+		rows = RowRange(0, 1);
 	}
 
+	GLsizeiptr rowSize = m_simulation->GetWidth()*getUVFormatSize(m_simulation->GetUVFormat());
+	void* data = m_uvStream->Map(rows.begin*rowSize, rows.getCount()*rowSize);
+	if (!data)
+		return;
+
 	//upload to gpu
-	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer_UV);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vector2df)*resWidth*resHeight, m_pUVBufferWrite, GL_DYNAMIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	RowRange segmentRows = activeRows;
+	if (uvBuffer)
+		memcpy(data, uvBuffer + rows.begin*rowSize, rows.getCount()*rowSize);
+	else
+		segmentRows = m_simulation->Step(data, rows);
+
+	m_uvOffset = m_uvStream->Unmap();
+	m_uvSegmentRows[segment] = segmentRows;
+	m_surfaceChanged = true;
 }
 
 void Water::_drawWaterMeshUV()
 {
+	PROFILE_SCOPE("Water::_drawWaterMeshUV");
+	GPU_PROFILE_SCOPE("Water::_drawWaterMeshUV");
+
+	//the gpu solver displaces the coordinates in the vertex shader
+	Shader* shader = m_gpuSimulation ? m_shader_water_height : m_shader_water_uv;
+
 	glViewport(0, 0, m_screenWidth, m_screenHeight);
-	m_shader_water_uv->bind();
+	shader->bind();
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, m_textureObject);
-	m_shader_water->uniform(RTHASH("water"),0);
+	shader->uniform(SHADER_UNIFORM("water"),0);
 
-	Shader::VertexAttributeIter iter =m_shader_water_uv->getVertexAttributesBegin();
-	for (; iter != m_shader_water_uv->getVertexAttributesEnd(); ++iter)
+	if (m_gpuSimulation)
 	{
-		if (iter->attributeType == E_Vertex_Attribute::EVA_POSITION)
-		{
-			auto meshAttribute = m_waterMesh_UV->getMeshAttribute(iter->attributeType);
-			glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer_Pos);
-			glEnableVertexAttribArray(iter->location);
-	
-			glVertexAttribPointer(iter->location,
-				meshAttribute->m_elementNum,
-				meshAttribute->m_elementType,
-				0,
-				meshAttribute->m_stride, 
-				reinterpret_cast<u32*>(meshAttribute->m_offset)
-				);
-		}
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, m_gpuSimulation->GetHeightTexture());
+		shader->uniform(SHADER_UNIFORM("heights"), 1);
+		shader->uniform(SHADER_UNIFORM("gridSize"), vector2df((float)m_gpuSimulation->GetWidth(), (float)m_gpuSimulation->GetHeight()));
+	}
+	else
+	{
+		shader->uniform(SHADER_UNIFORM("offsetScale"), getUVOffsetScale(m_simulation->GetUVFormat()));
+	}
+
+	//the coordinates read the segment uploaded last, each segment ends up
+	//with vertex arrays of its own
+	if (m_uvStream)
+		m_waterMesh_UV->setMeshAttributeSource(E_Vertex_Attribute::EVA_TEXCOORD0, m_uvStream->GetBuffer(), u32(m_uvOffset));
+
+	m_waterMesh_UV->draw(shader);
+
+	//the segment can be rewritten once the gpu passed this point
+	if (m_uvStream)
+		m_uvStream->Fence();
+}
+
+//after a stall, drop missed steps instead of running them all in one frame
+static const int MAX_GPU_CATCH_UP_STEPS = 4;
+
+void Water::_stepGpuSimulation()
+{
+	PROFILE_SCOPE("Water::_stepGpuSimulation");
+	GPU_PROFILE_SCOPE("Water::_stepGpuSimulation");
+
+	u64 stepPeriod = 1000000/(m_settings.simulationRate > 0 ? m_settings.simulationRate : 60);
+	u64 now = getTimeMicroseconds();
 
-		if(iter->attributeType == E_Vertex_Attribute::EVA_TEXCOORD0)
+	//flat water steps to flat water, the next drop starts on time
+	if (m_gpuSimulation->IsAtRest())
+	{
+		m_gpuNextStep = now;
+		return;
+	}
+
+	int steps = 0;
+	while (m_gpuNextStep <= now)
+	{
+		if (steps == MAX_GPU_CATCH_UP_STEPS)
 		{
-			auto meshAttribute = m_waterMesh_UV->getMeshAttribute(iter->attributeType);
-			glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer_UV);
-			glEnableVertexAttribArray(iter->location);
-
-			glVertexAttribPointer(iter->location,
-				meshAttribute->m_elementNum,
-				meshAttribute->m_elementType,
-				0,
-				meshAttribute->m_stride, 
-				reinterpret_cast<u32*>(meshAttribute->m_offset)
-				);
+			m_gpuNextStep = now + stepPeriod;
+			break;
 		}
+
+		m_gpuSimulation->Step();
+		m_gpuNextStep += stepPeriod;
+		++steps;
 	}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer_UV);
-	glDrawElements(GL_TRIANGLES, m_waterMesh_UV->getIndexCount(), GL_UNSIGNED_SHORT, NULL);
+	//the gpu solver does not track waves, every step until rest may move the surface
+	if (steps > 0)
+		m_surfaceChanged = true;
 }
 
-int inline SquaredDist(int sx, int sy, int dx, int dy)
+void Water::onTouches(const TouchEvent* touches, int count)
 {
-	return ((dx - sx) * (dx - sx)) + ((dy - sy) * (dy - sy));
-}
+	//screen pixels to grid cells, the grid covers the whole screen
+	float scaleX = float(m_settings.gridWidth - 1)/(m_screenWidth - 1);
+	float scaleY = float(m_settings.gridHeight - 1)/(m_screenHeight - 1);
 
-const int m_Drip_Radius = 12;
-const int m_Drip_Radius_Sqr = 12*12;
-void Water::_processTouchUV(int x, int y, int depth)
-{
-#if 1
-	int i,j,dist,finaldepth;
+	//custom stamps have no swept form, they drop at every sample
+	bool strokes = m_settings.touchStrokes && !m_touchStamp;
 
-	for (j = std::max(1, y - m_Drip_Radius); j < std::min(resHeight -1, y + m_Drip_Radius); j++)
+	m_touchDrops.clear();
+	for (int i=0; i<count; ++i)
 	{
-		for (i = std::max(1, x - m_Drip_Radius); i < std::min(resWidth - 1, x + m_Drip_Radius); i++)
+		if (touches[i].Phase == ETP_UP)
 		{
-			dist = SquaredDist(x,y,i,j);
-			if(dist < m_Drip_Radius_Sqr)
-			{
-				finaldepth = (int)((float)depth * ((float)(m_Drip_Radius - sqrt((float)dist))/(float)m_Drip_Radius));
+			m_strokeOpen = false;
+			continue;
+		}
 
-				if(finaldepth > 127) 
-					finaldepth = 127;
-				if(finaldepth < -127) 
-					finaldepth = -127;
+		WaterSimulationThread::DropEvent drop = {int(touches[i].X*scaleX), int(touches[i].Y*scaleY), TOUCH_DROP_DEPTH,
+			m_touchStamp, false, 0, 0};
 
-				SETBUFFER(m_pHightWrite, i,j,finaldepth);
-			}
+		//a drag continues from its last cell as one capsule instead of
+		//another full disc, which leaves no gaps on fast swipes
+		if (strokes && m_strokeOpen)
+		{
+			if (drop.x == m_strokeX && drop.y == m_strokeY)
+				continue;
+
+			drop.segment = true;
+			drop.fromX = m_strokeX;
+			drop.fromY = m_strokeY;
+			m_touchDrops.push_back(drop);
+
+			m_strokeX = drop.x;
+			m_strokeY = drop.y;
+			continue;
 		}
+
+		m_strokeOpen = strokes;
+		m_strokeX = drop.x;
+		m_strokeY = drop.y;
+
+		//a slow drag repeats cells, dropping twice would only deepen the hole
+		bool coalesced = false;
+		for (size_t j=0; j<m_touchDrops.size() && !coalesced; ++j)
+			coalesced = (!m_touchDrops[j].segment && m_touchDrops[j].x == drop.x && m_touchDrops[j].y == drop.y);
+
+		if (!coalesced)
+			m_touchDrops.push_back(drop);
 	}
-#else
 
+	if (!m_touchDrops.empty())
+		this->_queueDrops(&m_touchDrops[0], int(m_touchDrops.size()));
+}
 
-#endif
+void Water::_queueDrops(const WaterSimulationThread::DropEvent* drops, int count)
+{
+	//the gpu solver only knows the radial drop, drags drop at their samples
+	if (m_gpuSimulation)
+	{
+		for (int i=0; i<count; ++i)
+			m_gpuSimulation->Drop(drops[i].x, drops[i].y, drops[i].depth);
+	}
+	else
+	{
+		m_simulationThread->QueueDrops(drops, count);
+	}
 }
\ No newline at end of file
@@ -1,7 +1,13 @@
 #pragma once
 #include <GLES3/gl3.h>
+#include <vector>
 #include "shader.h"
 #include "Mesh.h"
+#include "GridMesh.h"
+#include "RippleSimulation.h"
+#include "TouchEvent.h"
+#include "WaterSimulationThread.h"
+#include "UniformBlocks.h"
 
 struct WaterVertex
 {
@@ -19,21 +25,139 @@ struct WaterVertex
 	float uv[2];
 };
 
+enum E_Water_Backend
+{
+	//RippleSimulation, coordinates streamed to the gpu every step
+	EWB_CPU,
+
+	//GpuRippleSimulation, falls back to EWB_CPU when the context lacks support
+	EWB_GPU,
+
+	EWB_COUNT,
+};
+
+const char* getWaterBackendName(E_Water_Backend backend);
+
+struct WaterSettings
+{
+	WaterSettings():backend(EWB_CPU)
+					,gridWidth(0)
+					,gridHeight(0)
+					,cellSize(3)
+					,touchStrokes(true)
+					,threadCount(0)
+					,heightPrecision(ERP_INT16)
+					,uvFormat(EUF_INT16)
+					,simulationRate(60)
+					,simulationThread(true)
+					,shaderCacheDirectory(NULL)
+	{
+	}
+
+	E_Water_Backend	backend;
+
+	//simulation grid, one vertex per cell, 0 derives it from the screen
+	int		gridWidth;
+	int		gridHeight;
+
+	//screen pixels per cell for a derived grid
+	int		cellSize;
+
+	//drags drop swept capsules between samples instead of a disc per sample
+	bool	touchStrokes;
+
+	//index order, strips and lod levels of the water mesh
+	GridMeshSettings	mesh;
+
+	//solver threads including the simulation thread, 0 for one per processor
+	int		threadCount;
+
+	//cpu height storage, s16 halves the bandwidth of the stencil pass
+	E_Ripple_Precision	heightPrecision;
+
+	//vertex format of the per frame coordinate offsets, the upload is 8, 4
+	//or 2 bytes a vertex
+	E_UV_Format			uvFormat;
+
+	//simulation steps per second, on its own thread or on the gpu
+	int		simulationRate;
+
+	//false steps once per Update() on the calling thread instead
+	bool	simulationThread;
+
+	//existing directory linked programs are cached in, NULL compiles them
+	//on every start
+	const char*	shaderCacheDirectory;
+};
+
+//! Passes reading a PassUniforms block, in the order of their blocks.
+enum E_Water_Pass
+{
+	EWP_WATER_QUAD=0,
+	EWP_CAUSTICS,
+	EWP_WATER_MESH,
+	EWP_COUNT
+};
+
 class Texture2D;
 class FrameBuffer;
+class StreamingBuffer;
+class GpuRippleSimulation;
 class Water
 {
 public:
 	Water(int screenWidth, int screenHeight, float dx);
 	~Water();
 
-	void Init();
+	void Init(const WaterSettings& settings = WaterSettings());
+
+	//! The programs started in Init() finished linking. Polls them, nothing
+	//! may draw before it returns true.
+	bool IsReady();
 
 	void Update();
+
+	//! Picks up the newest simulation step for Render(). False when Render()
+	//! would draw the same picture it drew last time.
+	bool UpdateSurface();
 	void Render();
 
 	void onTouch(int x, int y);
 
+	//! A frame's worth of touches at once, several landing on the same grid
+	//! cell drop only once.
+	void onTouches(const TouchEvent* touches, int count);
+
+	//! Shape touches drop on the cpu solver, null for the radial default.
+	//! The stamp must outlive the water.
+	void SetTouchStamp(const DropStamp* stamp);
+
+	//! RippleSimulation::GetHeightChecksum() of the cpu solver, 0 on the gpu.
+	//! Only stable while the simulation steps inside Update().
+	u64 GetHeightChecksum() const;
+
+	//! Level 0 draws every grid vertex, each further one half as many per side.
+	void SetMeshLod(int level);
+	int GetMeshLod() const;
+	int GetMeshLodCount() const;
+
+	//! Moves the cpu solver to a grid of one cell per cellSize screen pixels,
+	//! the waves are resampled onto it. The gpu solver keeps its grid.
+	void SetCellSize(int cellSize);
+	int GetGridWidth() const;
+	int GetGridHeight() const;
+
+	void SetSimulationRate(int stepsPerSecond);
+
+	//! Nothing moves and nothing is about to, the frame on screen is the
+	//! flat water. The gpu solver counts steps since its last drop instead of
+	//! reading the heights back, see GpuRippleSimulation::IsAtRest().
+	bool IsAtRest() const;
+
+	//! Share of its tick period the simulation thread is busy, 0 while the
+	//! simulation steps inside Update().
+	float GetSimulationLoad() const;
+
 private:
 	void _initShader();
 	void _initTexture();
@@ -51,11 +175,21 @@ private:
 
 	void _drawWaterMesh();
 
+	//! Binds the pass block, the first pass of a frame uploads the blocks of
+	//! all of them.
+	void _bindPassUniforms(E_Water_Pass pass);
+
 	void _initWaterMeshUV();
+	void _createWaterMeshUV();
+	void _releaseWaterMeshUV();
 	void _updateWaterMeshUV();
 	void _drawWaterMeshUV();
+	//without uvBuffer the simulation steps into the mapped rows, activeRows
+	//are then the rows the step may change
+	void _uploadWaterMeshUV(const RowRange& activeRows, const u8* uvBuffer);
+	void _stepGpuSimulation();
 
-	void _processTouchUV(int x, int y, int depth);
+	void _queueDrops(const WaterSimulationThread::DropEvent* drops, int count);
 
 private:
 	int				m_screenWidth;
@@ -72,9 +206,10 @@ private:
 
 	//water mesh uv
 	GLuint			m_vertexBuffer_Pos;
-	GLuint			m_vertexBuffer_UV;
 	GLuint			m_indexBuffer_UV;
 	MeshObject*		m_waterMesh_UV;
+	GridMesh*		m_waterGrid;
+	int				m_waterLod;
 
 	GLuint			m_quadVertexBuffer;
 	GLuint			m_quadIndexBuffer;
@@ -105,12 +240,78 @@ private:
 	Shader*			m_shader_waterMesh;
 	Shader*			m_shader_init;
 	Shader*			m_shader_water_uv;
+	Shader*			m_shader_water_height;
+	//linked in the background, IsReady() drops them as they finish
+	std::vector<Shader*>	m_pendingShaders;
+
+	//cpu solver
+	WaterSettings			m_settings;
+	RippleSimulation*		m_simulation;
+	WaterSimulationThread*	m_simulationThread;
+
+	//per frame uv upload and the offset of the newest data in it
+	StreamingBuffer*		m_uvStream;
+	GLintptr				m_uvOffset;
+
+	//rows of each stream segment that differ from the base coordinates
+	std::vector<RowRange>	m_uvSegmentRows;
+
+	//something Render() draws changed since it last ran
+	bool					m_surfaceChanged;
+
+	//frame and pass blocks of the shaders on ES 3, null before
+	UniformBlocks*			m_uniformBlocks;
+	//a pass of this frame uploaded the blocks, Render() fences them
+	bool					m_uniformBlocksWritten;
+
+	//drops of the touch batch being handed over
+	std::vector<WaterSimulationThread::DropEvent>	m_touchDrops;
+	const DropStamp*								m_touchStamp;
+
+	//the drag in progress and the grid cell of its last sample
+	bool									m_strokeOpen;
+	int										m_strokeX;
+	int										m_strokeY;
+
+	//gpu solver, replaces all of the above when set
+	GpuRippleSimulation*	m_gpuSimulation;
+	u64						m_gpuNextStep;
 };
 
 inline void Water::onTouch(int x, int y)
 {
 	//this->_processTouch(x,y);
 
-	float scale = 0.5f;
-	this->_processTouchUV(int(x*scale), int(y*scale),16);
-}
\ No newline at end of file
+	TouchEvent touch(x, y, 0);
+	this->onTouches(&touch, 1);
+}
+
+inline void
+Water::SetTouchStamp(const DropStamp* stamp)
+{
+	m_touchStamp = stamp;
+}
+
+inline int
+Water::GetMeshLod() const
+{
+	return m_waterLod;
+}
+
+inline int
+Water::GetMeshLodCount() const
+{
+	return m_waterGrid ? m_waterGrid->GetLevelCount() : 1;
+}
+
+inline int
+Water::GetGridWidth() const
+{
+	return m_settings.gridWidth;
+}
+
+inline int
+Water::GetGridHeight() const
+{
+	return m_settings.gridHeight;
+}
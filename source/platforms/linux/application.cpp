@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <core/Clock.h>
+#include "livewallpaper/water.h"
+#include "livewallpaper/ShaderCache.h"
+#include "application.h"
+
+static bool compareTouchFrame(const Application::ScriptedTouch& a, const Application::ScriptedTouch& b)
+{
+	return a.frame < b.frame;
+}
+
+bool Application::Init(int screenWidth, int screenHeight, int frameCount, bool deterministic,
+	E_Water_Backend backend, const char* shaderCacheDirectory)
+{
+	m_initStart = getTimeMicroseconds();
+	m_screenWidth = screenWidth;
+	m_screenHeight = screenHeight;
+	m_frameCount = frameCount;
+
+	//the simulation thread steps on its own clock, so the heights a frame
+	//sees depend on timing
+	WaterSettings settings;
+	settings.simulationThread = !deterministic;
+	settings.backend = backend;
+	settings.shaderCacheDirectory = shaderCacheDirectory;
+
+	LiveWallPaper::newInstance();
+	bool initialized = LiveWallPaper::instance()->Init(screenWidth,screenHeight,0,&settings);
+	m_initTime = getTimeMicroseconds() - m_initStart;
+	return initialized;
+}
+
+int Application::Run()
+{
+	printf("renderer %s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+	u64 totalTime = 0;
+	u64 minTime = ~u64(0);
+	u64 maxTime = 0;
+	size_t nextTouch = 0;
+	bool touchDown = false;
+	int presented = 0;
+	u64 firstFrameTime = 0;
+
+	m_checksums.clear();
+
+	for (int frame=0; frame<m_frameCount; ++frame)
+	{
+		this->_feedTouches(frame, nextTouch, touchDown);
+		m_framePacer.wait();
+
+		u64 start = getTimeMicroseconds();
+		LiveWallPaper::instance()->Update();
+		if (LiveWallPaper::instance()->Render())
+			++presented;
+		glFinish();
+		u64 frameTime = getTimeMicroseconds() - start;
+
+		if (presented == 1 && !firstFrameTime)
+			firstFrameTime = getTimeMicroseconds() - m_initStart;
+
+		if (m_checksumInterval > 0 && (frame + 1) % m_checksumInterval == 0)
+		{
+			HeightChecksum checksum;
+			checksum.frame = frame;
+			checksum.checksum = LiveWallPaper::instance()->GetHeightChecksum();
+			m_checksums.push_back(checksum);
+		}
+
+		totalTime += frameTime;
+		minTime = std::min(minTime, frameTime);
+		maxTime = std::max(maxTime, frameTime);
+	}
+
+	if (m_frameCount > 0)
+	{
+		printf("%d frames, %d presented, %d touches, avg %.3f ms, min %.3f ms, max %.3f ms\n",
+			m_frameCount, presented, (int)nextTouch,
+			totalTime/1000.0/m_frameCount, minTime/1000.0, maxTime/1000.0);
+	}
+
+	ShaderCache* shaderCache = ShaderCache::instance();
+	printf("startup: init %.3f ms, first frame %.3f ms, shader cache %d hits, %d misses\n",
+		m_initTime/1000.0, firstFrameTime/1000.0,
+		shaderCache ? shaderCache->GetHitCount() : 0, shaderCache ? shaderCache->GetMissCount() : 0);
+
+	GLenum error = glGetError();
+	if (error != GL_NO_ERROR)
+	{
+		printf("gl error 0x%x\n", error);
+		return 1;
+	}
+	return 0;
+}
+
+void Application::_feedTouches(int frame, size_t& nextTouch, bool& touchDown)
+{
+	if (m_replay.GetCount() > 0)
+	{
+		//recorded positions are in the recording's screen
+		int recordedWidth = std::max(m_replay.GetScreenWidth(), 1);
+		int recordedHeight = std::max(m_replay.GetScreenHeight(), 1);
+		while (nextTouch < size_t(m_replay.GetCount()) && m_replay.GetEntry(int(nextTouch)).frame <= u32(frame))
+		{
+			const TouchEvent& touch = m_replay.GetEntry(int(nextTouch)).touch;
+			if (touch.Phase == ETP_UP)
+				this->OnTouchUp();
+			else
+				this->OnTouch(touch.X*m_screenWidth/recordedWidth, touch.Y*m_screenHeight/recordedHeight);
+			++nextTouch;
+		}
+		return;
+	}
+
+	//feed the touches scripted for this frame, like mouse moves on win32,
+	//a frame without touches lifts the finger
+	while (nextTouch < m_touches.size() && m_touches[nextTouch].frame <= frame)
+	{
+		this->OnTouch(m_touches[nextTouch].x, m_touches[nextTouch].y);
+		++nextTouch;
+		touchDown = true;
+	}
+	if (touchDown && (nextTouch == m_touches.size() || m_touches[nextTouch].frame > frame + 1))
+	{
+		this->OnTouchUp();
+		touchDown = false;
+	}
+}
+
+void Application::OnTouch(int x, int y)
+{
+	LiveWallPaper::instance()->OnTouch(x,y);
+}
+
+void Application::OnTouchUp()
+{
+	LiveWallPaper::instance()->OnTouchUp();
+}
+
+bool Application::LoadTouchScript(const char* path)
+{
+	FILE* file = fopen(path, "r");
+	if (!file)
+		return false;
+
+	m_touches.clear();
+
+	char line[256];
+	while (fgets(line, sizeof(line), file))
+	{
+		char* comment = strchr(line, '#');
+		if (comment)
+			*comment = '\0';
+
+		ScriptedTouch touch;
+		if (sscanf(line, "%d %d %d", &touch.frame, &touch.x, &touch.y) == 3)
+			m_touches.push_back(touch);
+	}
+	fclose(file);
+
+	std::stable_sort(m_touches.begin(), m_touches.end(), compareTouchFrame);
+	return true;
+}
+
+void Application::BuildTouchScript()
+{
+	m_touches.clear();
+
+	//drag from the top left to the bottom right quarter, one move per frame
+	const int dragFrames = 60;
+	for (int i=0; i<dragFrames; ++i)
+	{
+		ScriptedTouch touch;
+		touch.frame = 10 + i;
+		touch.x = m_screenWidth/4 + m_screenWidth/2*i/dragFrames;
+		touch.y = m_screenHeight/4 + m_screenHeight/2*i/dragFrames;
+		m_touches.push_back(touch);
+	}
+
+	//then let it settle between taps
+	for (int i=0; i<4; ++i)
+	{
+		ScriptedTouch touch;
+		touch.frame = 120 + i*60;
+		touch.x = m_screenWidth*(1 + (i & 1)*2)/4;
+		touch.y = m_screenHeight*(1 + (i >> 1)*2)/4;
+		m_touches.push_back(touch);
+	}
+}
+
+bool Application::LoadTouchRecording(const char* path)
+{
+	return m_replay.Load(path);
+}
+
+void Application::StartRecording()
+{
+	m_recording.Clear();
+	LiveWallPaper::instance()->SetTouchRecording(&m_recording);
+}
+
+bool Application::SaveRecording(const char* path) const
+{
+	return m_recording.Save(path);
+}
+
+void Application::SetFrameRate(int framesPerSecond)
+{
+	m_framePacer.setFrameRate(framesPerSecond);
+}
+
+void Application::SetChecksumInterval(int interval)
+{
+	m_checksumInterval = interval;
+}
+
+bool Application::WriteChecksums(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "# frame height checksum, %dx%d\n", m_screenWidth, m_screenHeight);
+	for (size_t i=0; i<m_checksums.size(); ++i)
+		fprintf(file, "%d %016llx\n", m_checksums[i].frame, (unsigned long long)m_checksums[i].checksum);
+	fclose(file);
+	return true;
+}
+
+int Application::CompareChecksums(const char* path) const
+{
+	FILE* file = fopen(path, "r");
+	if (!file)
+	{
+		printf("can't read checksums %s\n", path);
+		return 1;
+	}
+
+	std::vector<HeightChecksum> expected;
+	char line[256];
+	while (fgets(line, sizeof(line), file))
+	{
+		char* comment = strchr(line, '#');
+		if (comment)
+			*comment = '\0';
+
+		HeightChecksum checksum;
+		unsigned long long value;
+		if (sscanf(line, "%d %llx", &checksum.frame, &value) == 2)
+		{
+			checksum.checksum = value;
+			expected.push_back(checksum);
+		}
+	}
+	fclose(file);
+
+	int mismatches = 0;
+	for (size_t i=0; i<expected.size(); ++i)
+	{
+		const HeightChecksum* actual = NULL;
+		for (size_t j=0; j<m_checksums.size() && !actual; ++j)
+		{
+			if (m_checksums[j].frame == expected[i].frame)
+				actual = &m_checksums[j];
+		}
+
+		if (!actual)
+		{
+			printf("frame %d: no checksum\n", expected[i].frame);
+			++mismatches;
+		}
+		else if (actual->checksum != expected[i].checksum)
+		{
+			//the first one is where the runs diverged
+			printf("frame %d: checksum %016llx, expected %016llx\n", expected[i].frame,
+				(unsigned long long)actual->checksum, (unsigned long long)expected[i].checksum);
+			++mismatches;
+		}
+	}
+	printf("%d of %d checksums match\n", int(expected.size()) - mismatches, int(expected.size()));
+	return mismatches;
+}
+
+bool Application::DumpFrame(const char* path) const
+{
+	std::vector<u8> pixels(m_screenWidth*m_screenHeight*4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_screenWidth, m_screenHeight, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+	if (glGetError() != GL_NO_ERROR)
+		return false;
+
+	FILE* file = fopen(path, "wb");
+	if (!file)
+		return false;
+
+	//gl rows start at the bottom
+	fprintf(file, "P6\n%d %d\n255\n", m_screenWidth, m_screenHeight);
+	for (int y=m_screenHeight - 1; y>=0; --y)
+	{
+		const u8* row = &pixels[y*m_screenWidth*4];
+		for (int x=0; x<m_screenWidth; ++x)
+			fwrite(row + x*4, 1, 3, file);
+	}
+	fclose(file);
+	return true;
+}
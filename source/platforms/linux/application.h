@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+#include <core/types.h>
+#include <core/singleton.h>
+#include "livewallpaper/livewallpaper.h"
+#include "livewallpaper/TouchRecording.h"
+#include "livewallpaper/water.h"
+#include <core/FramePacer.h>
+
+
+//! Headless host for CI boxes without a display.
+//!
+//! Renders into an off-screen EGL surface and drives the same Update/Render
+//! loop as the win32 window, with touches replayed from a script instead of
+//! the mouse.
+class Application:public Singleton<Application>
+{
+	friend class Singleton<Application>;
+protected:
+	Application():m_checksumInterval(0)
+				,m_framePacer(0)
+				,m_initStart(0)
+				,m_initTime(0)
+				,m_screenWidth(960)
+				,m_screenHeight(640)
+				,m_frameCount(600)
+	{
+	}
+	~Application()
+	{
+		LiveWallPaper::deleteInstance();
+	}
+
+public:
+	struct ScriptedTouch
+	{
+		int frame;
+		int x;
+		int y;
+	};
+
+	struct HeightChecksum
+	{
+		int frame;
+		u64 checksum;
+	};
+
+	//! deterministic steps the simulation once per frame on the calling thread,
+	//! so replays reproduce the same heights. shaderCacheDirectory may be NULL.
+	//! Checksums only match between runs on the same backend.
+	bool Init(int screenWidth, int screenHeight, int frameCount, bool deterministic,
+		E_Water_Backend backend, const char* shaderCacheDirectory);
+	int	 Run();
+	void OnTouch(int x, int y);
+	void OnTouchUp();
+
+	//! One touch per line, "frame x y" in screen pixels, '#' starts a comment.
+	//! The finger lifts after the last touch of a run of consecutive frames.
+	bool LoadTouchScript(const char* path);
+
+	//! Default script: a diagonal drag followed by a few taps.
+	void BuildTouchScript();
+
+	//! Replays a TouchRecording instead of the script, one recorded frame per
+	//! frame, positions scaled to this screen.
+	bool LoadTouchRecording(const char* path);
+
+	//! Records the touches of the next Run().
+	void StartRecording();
+	bool SaveRecording(const char* path) const;
+
+	//! Paces Run() like the win32 loop, 0 renders as fast as possible.
+	void SetFrameRate(int framesPerSecond);
+
+	//! Checksums the heights after every interval-th frame of Run(), 0 for never.
+	void SetChecksumInterval(int interval);
+
+	//! "frame checksum" per line.
+	bool WriteChecksums(const char* path) const;
+
+	//! Compares against a file from WriteChecksums(), prints and returns the
+	//! number of frames that differ or are missing.
+	int CompareChecksums(const char* path) const;
+
+	//! Writes the last rendered frame as a binary PPM.
+	bool DumpFrame(const char* path) const;
+
+private:
+	void _feedTouches(int frame, size_t& nextTouch, bool& touchDown);
+
+	std::vector<ScriptedTouch>	m_touches;
+	TouchRecording				m_replay;
+	TouchRecording				m_recording;
+	int							m_checksumInterval;
+	std::vector<HeightChecksum>	m_checksums;
+	FramePacer					m_framePacer;
+
+	//startup, from the start of Init() to the wallpaper's first frame
+	u64							m_initStart;
+	u64							m_initTime;
+
+public:
+	int		m_screenWidth;
+	int		m_screenHeight;
+	int		m_frameCount;
+
+};
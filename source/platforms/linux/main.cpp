@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <core/Profiler.h>
+#include "application.h"
+
+static void printUsage(const char* program)
+{
+	printf("usage: %s width height [-f frames] [-t touch script] [-o dump.ppm] [-p trace.json]\n"
+		"\t[-r replay.lwtr] [-w record.lwtr] [-n checksum interval] [-k write checksums] [-g golden checksums]\n"
+		"\t[-q 1 for adaptive quality] [-F frames per second] [-c shader cache directory]\n"
+		"\t[-b cpu|gpu simulation backend]\n", program);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+	{
+		printUsage(argv[0]);
+		return 2;
+	}
+
+	int screenWidth = atoi(argv[1]);
+	int screenHeight = atoi(argv[2]);
+	int frameCount = 600;
+	const char* touchScript = NULL;
+	const char* dumpPath = NULL;
+	const char* tracePath = NULL;
+	const char* replayPath = NULL;
+	const char* recordPath = NULL;
+	const char* checksumPath = NULL;
+	const char* goldenPath = NULL;
+	int checksumInterval = 60;
+	bool adaptiveQuality = false;
+	int frameRate = 0;
+	const char* shaderCacheDirectory = NULL;
+	E_Water_Backend backend = EWB_CPU;
+
+	for (int i=3; i<argc; i+=2)
+	{
+		if (i + 1 >= argc)
+		{
+			printUsage(argv[0]);
+			return 2;
+		}
+
+		if (strcmp(argv[i], "-f") == 0)
+			frameCount = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-t") == 0)
+			touchScript = argv[i + 1];
+		else if (strcmp(argv[i], "-o") == 0)
+			dumpPath = argv[i + 1];
+		else if (strcmp(argv[i], "-p") == 0)
+			tracePath = argv[i + 1];
+		else if (strcmp(argv[i], "-r") == 0)
+			replayPath = argv[i + 1];
+		else if (strcmp(argv[i], "-w") == 0)
+			recordPath = argv[i + 1];
+		else if (strcmp(argv[i], "-n") == 0)
+			checksumInterval = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-k") == 0)
+			checksumPath = argv[i + 1];
+		else if (strcmp(argv[i], "-g") == 0)
+			goldenPath = argv[i + 1];
+		else if (strcmp(argv[i], "-F") == 0)
+			frameRate = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-c") == 0)
+			shaderCacheDirectory = argv[i + 1];
+		else if (strcmp(argv[i], "-q") == 0)
+			adaptiveQuality = atoi(argv[i + 1]) != 0;
+		else if (strcmp(argv[i], "-b") == 0)
+		{
+			backend = EWB_COUNT;
+			for (int j=0; j<EWB_COUNT; ++j)
+			{
+				if (strcmp(argv[i + 1], getWaterBackendName(E_Water_Backend(j))) == 0)
+					backend = E_Water_Backend(j);
+			}
+			if (backend == EWB_COUNT)
+			{
+				printUsage(argv[0]);
+				return 2;
+			}
+		}
+		else
+		{
+			printUsage(argv[0]);
+			return 2;
+		}
+	}
+
+	//before the wallpaper, so it picks up gpu timings too
+	if (tracePath)
+		Profiler::newInstance();
+
+	int result = 0;
+	Application* app = Application::newInstance();
+	//checksums only compare when every frame steps the simulation exactly once
+	bool deterministic = replayPath || checksumPath || goldenPath;
+	if (!app->Init(screenWidth, screenHeight, frameCount, deterministic, backend, shaderCacheDirectory))
+	{
+		printf("no EGL context\n");
+		result = 1;
+	}
+	else if (touchScript && !app->LoadTouchScript(touchScript))
+	{
+		printf("can't read touch script %s\n", touchScript);
+		result = 1;
+	}
+	else if (replayPath && !app->LoadTouchRecording(replayPath))
+	{
+		printf("can't read touch recording %s\n", replayPath);
+		result = 1;
+	}
+	else
+	{
+		if (!touchScript)
+			app->BuildTouchScript();
+		if (recordPath)
+			app->StartRecording();
+		//tier changes depend on timing, replays would not match
+		if (adaptiveQuality && !deterministic)
+			LiveWallPaper::instance()->SetAdaptiveQuality(true);
+		if (checksumPath || goldenPath)
+			app->SetChecksumInterval(checksumInterval);
+		app->SetFrameRate(frameRate);
+
+		result = app->Run();
+		if (dumpPath && !app->DumpFrame(dumpPath))
+			result = 1;
+		if (recordPath && !app->SaveRecording(recordPath))
+			result = 1;
+		if (checksumPath && !app->WriteChecksums(checksumPath))
+			result = 1;
+		if (goldenPath && app->CompareChecksums(goldenPath) != 0)
+			result = 1;
+	}
+	Application::deleteInstance();
+
+	if (tracePath)
+	{
+		Profiler::instance()->writeStats(stdout);
+		if (!Profiler::instance()->writeChromeTrace(tracePath))
+			result = 1;
+		Profiler::deleteInstance();
+	}
+	return result;
+}
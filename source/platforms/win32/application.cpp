@@ -3,6 +3,7 @@
 #include <iostream>
 #include <string>
 #include "application.h"
+#include "livewallpaper/water.h"
 
 using namespace std;
 
@@ -11,6 +12,10 @@ LRESULT	CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 void Application::ResizeScene(unsigned int width, unsigned int height)
 {
 	//m_game->ResizeScene(width,height);
+
+	//arrives while the window is created, before the wallpaper exists
+	if (LiveWallPaper::instance())
+		LiveWallPaper::instance()->Invalidate();
 }
 
 void Application::CloseRenderWindow(void)
@@ -197,6 +202,13 @@ LRESULT CALLBACK WndProc(	HWND	hWnd,			// Handle For This Window
 			return 0;								// Jump Back
 		}
 
+		case WM_PAINT:								// Window Uncovered, Present Again
+		{
+			if (LiveWallPaper::instance())
+				LiveWallPaper::instance()->Invalidate();
+			break;									// DefWindowProc Validates It
+		}
+
 		case  WM_LBUTTONDOWN:
 		{
 			g_bLeftMouseDown = true;
@@ -209,6 +221,7 @@ LRESULT CALLBACK WndProc(	HWND	hWnd,			// Handle For This Window
 				//int pos_y = GET_Y_LPARAM(lParam);
 				//Application::instance()->OnTouch(pos_x,pos_y);
 			g_bLeftMouseDown = false;
+			Application::instance()->OnTouchUp();
 			return 0;
 		}
 
@@ -250,19 +263,10 @@ int Application::Run()
 		}
 		else										// If There Are No Messages
 		{
-			// Draw The Scene.  Watch For ESC Key And Quit Messages From DrawGLScene()
-			if (active)								// Program Active?
+			if (keys[VK_ESCAPE])					// Was ESC Pressed?
 			{
-				if (keys[VK_ESCAPE])				// Was ESC Pressed?
-				{
-					done=TRUE;						// ESC Signalled A Quit
-				}
-				else								// Not Time To Quit, Update Screen
-				{
-					//m_game->RenderScene();
-					LiveWallPaper::instance()->Update();
-					LiveWallPaper::instance()->Render();
-				}
+				done=TRUE;							// ESC Signalled A Quit
+				continue;
 			}
 
 			if (keys[VK_F1])						// Is F1 Being Pressed?
@@ -276,6 +280,42 @@ int Application::Run()
 					return 0;						// Quit If Window Was Not Created
 				}
 			}
+
+			if (keys[VK_F2])						// Toggle Touch Recording
+			{
+				keys[VK_F2]=FALSE;
+				if (LiveWallPaper::instance()->GetTouchRecording())
+				{
+					LiveWallPaper::instance()->SetTouchRecording(NULL);
+					m_touchRecording.Save("touches.lwtr");
+				}
+				else
+				{
+					m_touchRecording.Clear();
+					LiveWallPaper::instance()->SetTouchRecording(&m_touchRecording);
+				}
+			}
+
+			if (!active || LiveWallPaper::instance()->IsIdle())
+			{
+				//nothing moves, block until input arrives, or until the next
+				//frame of the idle rate
+				DWORD timeout = (active && m_idleFrameRate > 0) ? DWORD(1000/m_idleFrameRate) : INFINITE;
+				if (MsgWaitForMultipleObjects(0, NULL, FALSE, timeout, QS_ALLINPUT) != WAIT_TIMEOUT)
+				{
+					//input renders right away
+					m_framePacer.restart();
+					continue;
+				}
+			}
+			else
+			{
+				m_framePacer.wait();				// Sleep Until The Next Frame Is Due
+			}
+
+			//m_game->RenderScene();
+			LiveWallPaper::instance()->Update();
+			LiveWallPaper::instance()->Render();
 		}
 	}
 
@@ -284,12 +324,29 @@ int Application::Run()
 	return (msg.wParam);							
 }
 
-bool Application::Init(int screenWidth, int screenHeight)
+bool Application::Init(int screenWidth, int screenHeight, E_Water_Backend backend)
 {
 	if (CreateRenderWindow(L"LiveWallPaper",screenWidth,screenHeight,16,false,m_hWnd))
 	{
+		//linked programs are kept next to the working directory, later starts
+		//load them instead of compiling
+		WaterSettings settings;
+		settings.backend = backend;
+		if (CreateDirectoryA("shadercache", NULL) || GetLastError() == ERROR_ALREADY_EXISTS)
+			settings.shaderCacheDirectory = "shadercache";
+
 		LiveWallPaper::newInstance();
-		LiveWallPaper::instance()->Init(screenWidth,screenHeight,m_hWnd);
+		if (!LiveWallPaper::instance()->Init(screenWidth,screenHeight,m_hWnd,&settings))
+		{
+			LiveWallPaper::deleteInstance();
+			CloseRenderWindow();
+			return false;
+		}
+		LiveWallPaper::instance()->SetAdaptiveQuality(true);
+
+		//vsync caps the rate, the pacer keeps the cpu asleep in between
+		LiveWallPaper::instance()->SetSwapInterval(1);
+		m_framePacer.setFrameRate(m_frameRate);
 		return true;
 	}
 	return false;
@@ -299,3 +356,8 @@ void Application::OnTouch(int x, int y)
 {
 	LiveWallPaper::instance()->OnTouch(x,y);
 }
+
+void Application::OnTouchUp()
+{
+	LiveWallPaper::instance()->OnTouchUp();
+}
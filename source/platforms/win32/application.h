@@ -2,7 +2,10 @@
 
 #include <Windows.h>
 #include <core/singleton.h>
+#include <core/FramePacer.h>
 #include "livewallpaper/livewallpaper.h"
+#include "livewallpaper/TouchRecording.h"
+#include "livewallpaper/water.h"
 
 
 class Application:public Singleton<Application>
@@ -19,6 +22,8 @@ protected:
 				,m_screenWidth(960)
 				,m_screenHeight(640)
 				,m_bIsLMouseDown(false)
+				,m_frameRate(60)
+				,m_idleFrameRate(0)
 	{
 		ZeroMemory(keys,sizeof(keys));
 	}
@@ -27,10 +32,11 @@ protected:
 	}
 
 public:
-	bool Init(int screenWidth, int screenHeight);
+	bool Init(int screenWidth, int screenHeight, E_Water_Backend backend);
 	int	 Run();
 	void ResizeScene(unsigned int width, unsigned int height);
 	void OnTouch(int x, int y);
+	void OnTouchUp();
 
 protected:
 	bool CreateRenderWindow(LPCWSTR title, int width, int height, int bits, bool isFullScreen,HWND& m_hWnd );
@@ -50,6 +56,15 @@ public:
 	bool	m_bFullscreen;
 	bool    m_bIsLMouseDown;
 
+	//F2 toggles recording the touches into touches.lwtr
+	TouchRecording	m_touchRecording;
+
+	//frames per second while the water moves, and while it rests, 0 renders
+	//nothing until input arrives
+	int				m_frameRate;
+	int				m_idleFrameRate;
+	FramePacer		m_framePacer;
+
 	int		m_screenWidth;
 	int		m_screenHeight;
 
@@ -1,14 +1,21 @@
 #include <Windows.h>
+#include <string.h>
 #include "application.h"
 
 int main(int argc, char *argv[])
 {
 	int screenWidth = atoi(argv[1]);
 	int screenHeight = atoi(argv[2]);
+	//an optional third argument names the simulation backend, cpu or gpu
+	E_Water_Backend backend = EWB_CPU;
+	for (int j=0; argc > 3 && j<EWB_COUNT; ++j)
+	{
+		if (strcmp(argv[3], getWaterBackendName(E_Water_Backend(j))) == 0)
+			backend = E_Water_Backend(j);
+	}
 
 	Application* app = Application::newInstance();
-	app->Init(screenWidth, screenHeight);
-	if (app != NULL)
+	if (app->Init(screenWidth, screenHeight, backend))
 	{
 		app->Run();
 	}